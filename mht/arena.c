@@ -0,0 +1,191 @@
+/*********************************************************************
+ * FILE: arena.C                                                     *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Routines for EPOCH_ARENA.  See arena.H for details.             *
+ *                                                                   *
+ *********************************************************************/
+
+#include <new>
+
+#include "arena.h"
+
+/*-------------------------------------------------------------------*
+ | Sizes of the headers in front of each slab and each object
+ |
+ | Every object is preceded by a pointer to its epoch.  Both headers
+ | are padded out so that what follows them is aligned for any type.
+ *-------------------------------------------------------------------*/
+
+static const size_t ALIGN_BYTES = alignof( max_align_t );
+
+static size_t roundUp( size_t numBytes )
+{
+    return (numBytes + ALIGN_BYTES - 1) & ~(ALIGN_BYTES - 1);
+}
+
+#define SLAB_HEADER_BYTES roundUp( sizeof( SLAB ) )
+#define OBJECT_HEADER_BYTES roundUp( sizeof( EPOCH * ) )
+
+/*-------------------------------------------------------------------*
+ | EPOCH_ARENA::EPOCH_ARENA() -- start the first epoch
+ *-------------------------------------------------------------------*/
+
+EPOCH_ARENA::EPOCH_ARENA():
+    m_current( new EPOCH ),
+    m_spareSlabs( 0 ),
+    m_numSlabs( 0 ),
+    m_numSpareSlabs( 0 )
+{
+    m_current->numLive = 0;
+    m_current->slabs = 0;
+    m_current->top = m_current->end = 0;
+}
+
+/*-------------------------------------------------------------------*
+ | EPOCH_ARENA::alloc() -- get memory in the current epoch
+ *-------------------------------------------------------------------*/
+
+void *EPOCH_ARENA::alloc( size_t size )
+{
+
+
+    size_t numBytes = roundUp( OBJECT_HEADER_BYTES + size );
+    char *block;
+
+    if( m_current->top == 0 ||
+        (size_t)(m_current->end - m_current->top) < numBytes )
+    {
+        addSlab( numBytes );
+    }
+
+    block = m_current->top;
+    m_current->top += numBytes;
+    m_current->numLive++;
+
+    *(EPOCH **)block = m_current;
+
+    return block + OBJECT_HEADER_BYTES;
+}
+
+/*-------------------------------------------------------------------*
+ | EPOCH_ARENA::free() -- count an object off its epoch
+ *-------------------------------------------------------------------*/
+
+void EPOCH_ARENA::free( void *ptr )
+{
+
+
+    EPOCH *epoch;
+
+    if( ptr == 0 )
+    {
+        return;
+    }
+
+    epoch = *(EPOCH **)((char *)ptr - OBJECT_HEADER_BYTES);
+    epoch->numLive--;
+
+    if( epoch->numLive == 0 && epoch != m_current )
+    {
+        reclaim( epoch );
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | EPOCH_ARENA::beginEpoch() -- end the current epoch and start
+ |                              another
+ |
+ | If nothing is left of the current epoch, its slabs are simply
+ | used again from the start.
+ *-------------------------------------------------------------------*/
+
+void EPOCH_ARENA::beginEpoch()
+{
+
+
+    if( m_current->numLive == 0 )
+    {
+        reclaim( m_current );
+    }
+
+    m_current = new EPOCH;
+    m_current->numLive = 0;
+    m_current->slabs = 0;
+    m_current->top = m_current->end = 0;
+}
+
+/*-------------------------------------------------------------------*
+ | EPOCH_ARENA::addSlab() -- give the current epoch a new slab, with
+ |                           room for at least numBytes
+ |
+ | A spare slab is used if there is one.  Objects too big for a
+ | normal slab get a slab of their own.
+ *-------------------------------------------------------------------*/
+
+void EPOCH_ARENA::addSlab( size_t numBytes )
+{
+
+
+    SLAB *slab;
+
+    if( SLAB_HEADER_BYTES + numBytes > SLAB_BYTES )
+    {
+        slab = (SLAB *)::operator new( SLAB_HEADER_BYTES + numBytes );
+        slab->numBytes = SLAB_HEADER_BYTES + numBytes;
+        m_numSlabs++;
+    }
+    else if( m_spareSlabs != 0 )
+    {
+        slab = m_spareSlabs;
+        m_spareSlabs = slab->next;
+        m_numSpareSlabs--;
+    }
+    else
+    {
+        slab = (SLAB *)::operator new( SLAB_BYTES );
+        slab->numBytes = SLAB_BYTES;
+        m_numSlabs++;
+    }
+
+    slab->next = m_current->slabs;
+    m_current->slabs = slab;
+    m_current->top = (char *)slab + SLAB_HEADER_BYTES;
+    m_current->end = (char *)slab + slab->numBytes;
+}
+
+/*-------------------------------------------------------------------*
+ | EPOCH_ARENA::reclaim() -- put the slabs of an epoch that has no
+ |                           objects left onto the spare list, and
+ |                           delete the epoch
+ |
+ | Slabs that were made for one big object go back to the heap.
+ *-------------------------------------------------------------------*/
+
+void EPOCH_ARENA::reclaim( EPOCH *epoch )
+{
+
+
+    SLAB *slab;
+
+    while( epoch->slabs != 0 )
+    {
+        slab = epoch->slabs;
+        epoch->slabs = slab->next;
+
+        if( slab->numBytes == SLAB_BYTES )
+        {
+            slab->next = m_spareSlabs;
+            m_spareSlabs = slab;
+            m_numSpareSlabs++;
+        }
+        else
+        {
+            ::operator delete( slab );
+            m_numSlabs--;
+        }
+    }
+
+    delete epoch;
+}
@@ -0,0 +1,103 @@
+/*********************************************************************
+ * FILE: arena.H                                                     *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Declaration of EPOCH_ARENA, which hands out the memory for      *
+ *   objects that are made in batches ("epochs") and that mostly     *
+ *   die together, some time later.  The T_HYPOs of one scan of the  *
+ *   mht algorithm are the case in point (see mht.H): they're all    *
+ *   made during one scan, and N-scan pruning deletes nearly all of  *
+ *   them within a few scans.                                        *
+ *                                                                   *
+ *   The memory of an epoch is taken from slabs of SLAB_BYTES, in    *
+ *   order, by advancing a pointer, so objects made one after the    *
+ *   other lie next to each other.  Freeing an object only counts    *
+ *   it off its epoch.  Once an epoch has ended and all its objects  *
+ *   have been freed, its slabs are kept to be used by later         *
+ *   epochs.  So an object that outlives the others of its epoch     *
+ *   just keeps their slabs from being reused; it's always safe.     *
+ *                                                                   *
+ *   EPOCH_ARENA's have the following member functions:              *
+ *                                                                   *
+ *     EPOCH_ARENA()                                                 *
+ *       The constructor takes no arguments.  The first epoch starts *
+ *       right away.                                                 *
+ *                                                                   *
+ *     void *alloc( size_t size )                                    *
+ *       Get size bytes in the current epoch, aligned for any type.  *
+ *                                                                   *
+ *     void free( void *ptr )                                        *
+ *       Give back memory got from alloc().  ptr may be 0.           *
+ *                                                                   *
+ *     void beginEpoch()                                             *
+ *       End the current epoch, and start a new one.                 *
+ *                                                                   *
+ *     long getNumSlabs()                                            *
+ *     long getNumSpareSlabs()                                       *
+ *       The number of slabs taken from the heap, and the number of  *
+ *       them not in use by any epoch.                               *
+ *                                                                   *
+ *   An EPOCH_ARENA never gives its slabs back to the heap (except   *
+ *   those made for single objects bigger than a slab), and it isn't *
+ *   safe to use from more than one thread at a time.                *
+ *                                                                   *
+ *********************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+class EPOCH_ARENA
+{
+private:
+
+    enum { SLAB_BYTES = 64 * 1024 };
+
+    struct SLAB
+    {
+        SLAB *next;
+        size_t numBytes;                 // including this header
+    };
+
+    struct EPOCH
+    {
+        long numLive;                    // objects not yet freed
+        SLAB *slabs;                     // slabs in use, the one being
+        char *top;                       //   taken from first, and the
+        char *end;                       //   unused part of it
+    };
+
+    EPOCH *m_current;
+    SLAB *m_spareSlabs;
+    long m_numSlabs;
+    long m_numSpareSlabs;
+
+public:
+
+    EPOCH_ARENA();
+
+    void *alloc( size_t size );
+    void free( void *ptr );
+    void beginEpoch();
+
+    long getNumSlabs()
+    {
+        return m_numSlabs;
+    }
+    long getNumSpareSlabs()
+    {
+        return m_numSpareSlabs;
+    }
+
+private:
+
+    EPOCH_ARENA( const EPOCH_ARENA & );
+    EPOCH_ARENA &operator=( const EPOCH_ARENA & );
+
+    void addSlab( size_t numBytes );
+    void reclaim( EPOCH *epoch );
+};
+
+#endif
@@ -24,7 +24,8 @@
  *   "row" refers to nodes on one side of the graph, "col" refers    *
  *   to nodes on the other, and a ROW_COL_COST structure stores      *
  *   the cost of assigning one "row" to one "col" (the cost of an    *
- *   arc between the row and the column).                            *
+ *   arc between the row and the column).  Costs are MHT_REAL's (see *
+ *   precision.H), so they're floats in a single-precision build.    *
  *                                                                   *
  *   Rows and columns are identified with positive integers.  If a   *
  *   row may be left unassigned, then the problem representation     *
@@ -191,6 +192,7 @@
 #define ASSIGN_H
 #include <math.h>
 #include "except.h"
+#include "precision.h"
 #include "vector.h"
 
 #ifdef DECLARE_ASSIGN
@@ -212,7 +214,7 @@ struct ROW_COL_COST
 {
     int row;
     int col;
-    double cost;
+    MHT_REAL cost;
     void *tag;
 
     ROW_COL_COST():
@@ -223,7 +225,7 @@ struct ROW_COL_COST
     {
     }
 
-    ROW_COL_COST( int rowArg, int colArg, double costArg ):
+    ROW_COL_COST( int rowArg, int colArg, MHT_REAL costArg ):
         row( rowArg ),
         col( colArg ),
         cost( costArg ),
@@ -231,7 +233,7 @@ struct ROW_COL_COST
     {
     }
 
-    ROW_COL_COST( int rowArg, int colArg, double costArg, void *tagArg ):
+    ROW_COL_COST( int rowArg, int colArg, MHT_REAL costArg, void *tagArg ):
         row( rowArg ),
         col( colArg ),
         cost( costArg ),
@@ -239,7 +241,7 @@ struct ROW_COL_COST
     {
     }
 
-    void set( int rowArg, int colArg, double costArg )
+    void set( int rowArg, int colArg, MHT_REAL costArg )
     {
         row = rowArg;
         col = colArg;
@@ -247,7 +249,7 @@ struct ROW_COL_COST
         tag = this;
     }
 
-    void set( int rowArg, int colArg, double costArg, void *tagArg )
+    void set( int rowArg, int colArg, MHT_REAL costArg, void *tagArg )
     {
         row = rowArg;
         col = colArg;
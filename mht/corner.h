@@ -2,72 +2,98 @@
 #define CORNER_H
 
 #include "list.h"		// for DLISTnode
-#include <vector>		// for std::vector<>
+#include <string.h>		// for memset()
+#include <list>			// for std::list<>
 
 /*-----------------------------------------------*
  * Data structures for storing input corner data
  *-----------------------------------------------*/
-class Texture_t
+
+/*
+ * TEXTURE_PIXEL -- one pixel of a texture patch
+ *
+ * Normally the pixels are stored as they're read.  If TEXTURE_8BIT is
+ * defined (it must be defined the same way for the mht library and for
+ * the program using it), they're rounded to the nearest integer in
+ * 0..255 and stored in a byte each, which is all that 8-bit images
+ * need, and cuts a patch from 100 bytes to 25.
+ */
+#ifdef TEXTURE_8BIT
+typedef unsigned char TEXTURE_PIXEL;
+#else
+typedef float TEXTURE_PIXEL;
+#endif
+
+/*
+ * TEXTURE_RADIUS, TEMPLATE_RADIUS -- sizes of the texture patch kept
+ * with each corner, which is (2 * TEXTURE_RADIUS + 1) pixels square,
+ * and of the template that's slid around inside it when textures are
+ * compared, which is (2 * TEMPLATE_RADIUS + 1) square.  The defaults
+ * give a 3x3 template in a 5x5 patch.  Like TEXTURE_8BIT, they can be
+ * set on the compiler's command line, the same way for the mht library
+ * and for the program using it.  gate.C has correlation kernels for
+ * 3x3 in 5x5, 5x5 in 7x7 and 7x7 in 9x9.
+ */
+#ifndef TEXTURE_RADIUS
+#define TEXTURE_RADIUS 2
+#endif
+#ifndef TEMPLATE_RADIUS
+#define TEMPLATE_RADIUS 1
+#endif
+
+template<int patchRadius>
+class TEXTURE_OF
 // Class to "hide-away' texture information
 // to make it easier to modify in the future.
-// The current list of member variables is
-// temporary and only exists for legacy's sake.
+// The pixels of the patch are kept inline, a row at a
+// time, so copying one allocates nothing.
 {
+public:
+    enum { RADIUS = patchRadius,
+           WIDTH = 2 * patchRadius + 1,
+           NUM_PIXELS = WIDTH * WIDTH };
+
 private:
-    std::vector<float> m_int;
+    TEXTURE_PIXEL m_int[NUM_PIXELS];
 
-public:
-    Texture_t() :
-        m_int(25, 0)
+    static TEXTURE_PIXEL toPixel(float I)
     {
+#ifdef TEXTURE_8BIT
+        // NaNs and negative values go to 0
+        return !(I > 0.f) ? 0 : I >= 255.f ? 255 : (TEXTURE_PIXEL)(I + 0.5f);
+#else
+        return I;
+#endif
     }
 
+public:
+    TEXTURE_OF()
+    {
+        memset(m_int, 0, sizeof(m_int));
+    }
 
-    Texture_t(float I1, float I2, float I3, float I4, float I5,
-              float I6, float I7, float I8, float I9, float I10,
-              float I11, float I12, float I13, float I14, float I15,
-              float I16, float I17, float I18, float I19, float I20,
-              float I21, float I22, float I23, float I24, float I25):
-        m_int(25)
+    // I points to NUM_PIXELS values, row by row
+    TEXTURE_OF(const float *I)
     {
-        m_int[0] = I1;
-        m_int[1] = I2;
-        m_int[2] = I3;
-        m_int[3] = I4;
-        m_int[4] = I5;
-        m_int[5] = I6;
-        m_int[6] = I7;
-        m_int[7] = I8;
-        m_int[8] = I9;
-        m_int[9] = I10;
-        m_int[10] = I11;
-        m_int[11] = I12;
-        m_int[12] = I13;
-        m_int[13] = I14;
-        m_int[14] = I15;
-        m_int[15] = I16;
-        m_int[16] = I17;
-        m_int[17] = I18;
-        m_int[18] = I19;
-        m_int[19] = I20;
-        m_int[20] = I21;
-        m_int[21] = I22;
-        m_int[22] = I23;
-        m_int[23] = I24;
-        m_int[24] = I25;
+        int i;
+
+        for (i = 0; i < NUM_PIXELS; i++)
+            m_int[i] = toPixel(I[i]);
     }
 
-    float& operator[](const size_t &index)
+    TEXTURE_PIXEL& operator[](const size_t &index)
     {
         return(m_int[index]);
     }
 
-    const float& operator[](const size_t &index) const
+    const TEXTURE_PIXEL& operator[](const size_t &index) const
     {
         return(m_int[index]);
     }
 };
 
+typedef TEXTURE_OF<TEXTURE_RADIUS> Texture_t;
+
 class CORNER:public DLISTnode
 {
 public:
@@ -0,0 +1,627 @@
+/*********************************************************************
+ * FILE: gate.C                                                      *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Batched validation gating of 2D position reports and their      *
+ *   texture patches.  See gate.H for details.                       *
+ *                                                                   *
+ *********************************************************************/
+
+#if defined( __AVX__ )
+#include <immintrin.h>
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+#include "gate.h"
+
+/*-------------------------------------------------------------------*
+ | GATE_REG -- a vector register of MHT_REAL's, with the operations
+ |             the gating kernel needs
+ |
+ | gateMask() sets bit k of its result if lane k of d is not greater
+ | than max (so a NaN passes).  Single precision fits twice as many
+ | lanes in a register.
+ *-------------------------------------------------------------------*/
+
+#if defined( __AVX__ ) && defined( MHT_SINGLE_PRECISION )
+
+typedef __m256 GATE_REG;
+enum { GATE_LANES = 8 };
+
+static inline GATE_REG gateSet1( MHT_REAL val )
+{
+    return _mm256_set1_ps( val );
+}
+
+static inline GATE_REG gateLoad( const MHT_REAL *src )
+{
+    return _mm256_loadu_ps( src );
+}
+
+static inline GATE_REG gateDistance( GATE_REG x, GATE_REG y,
+                                     GATE_REG px, GATE_REG py,
+                                     GATE_REG l00, GATE_REG l10,
+                                     GATE_REG l11 )
+{
+    __m256 Wx, Wy;
+
+    Wx = _mm256_div_ps( _mm256_sub_ps( x, px ), l00 );
+    Wy = _mm256_div_ps( _mm256_sub_ps( _mm256_sub_ps( y, py ),
+                                       _mm256_mul_ps( l10, Wx ) ),
+                        l11 );
+    return _mm256_add_ps( _mm256_mul_ps( Wx, Wx ),
+                          _mm256_mul_ps( Wy, Wy ) );
+}
+
+static inline int gateMask( GATE_REG d, GATE_REG max )
+{
+    return _mm256_movemask_ps( _mm256_cmp_ps( d, max, _CMP_NGT_UQ ) );
+}
+
+static inline void gateStore( MHT_REAL *dst, GATE_REG a )
+{
+    _mm256_storeu_ps( dst, a );
+}
+
+#elif defined( __AVX__ )
+
+typedef __m256d GATE_REG;
+enum { GATE_LANES = 4 };
+
+static inline GATE_REG gateSet1( MHT_REAL val )
+{
+    return _mm256_set1_pd( val );
+}
+
+static inline GATE_REG gateLoad( const MHT_REAL *src )
+{
+    return _mm256_loadu_pd( src );
+}
+
+static inline GATE_REG gateDistance( GATE_REG x, GATE_REG y,
+                                     GATE_REG px, GATE_REG py,
+                                     GATE_REG l00, GATE_REG l10,
+                                     GATE_REG l11 )
+{
+    __m256d Wx, Wy;
+
+    Wx = _mm256_div_pd( _mm256_sub_pd( x, px ), l00 );
+    Wy = _mm256_div_pd( _mm256_sub_pd( _mm256_sub_pd( y, py ),
+                                       _mm256_mul_pd( l10, Wx ) ),
+                        l11 );
+    return _mm256_add_pd( _mm256_mul_pd( Wx, Wx ),
+                          _mm256_mul_pd( Wy, Wy ) );
+}
+
+static inline int gateMask( GATE_REG d, GATE_REG max )
+{
+    return _mm256_movemask_pd( _mm256_cmp_pd( d, max, _CMP_NGT_UQ ) );
+}
+
+static inline void gateStore( MHT_REAL *dst, GATE_REG a )
+{
+    _mm256_storeu_pd( dst, a );
+}
+
+#elif defined( __SSE2__ ) && defined( MHT_SINGLE_PRECISION )
+
+typedef __m128 GATE_REG;
+enum { GATE_LANES = 4 };
+
+static inline GATE_REG gateSet1( MHT_REAL val )
+{
+    return _mm_set1_ps( val );
+}
+
+static inline GATE_REG gateLoad( const MHT_REAL *src )
+{
+    return _mm_loadu_ps( src );
+}
+
+static inline GATE_REG gateDistance( GATE_REG x, GATE_REG y,
+                                     GATE_REG px, GATE_REG py,
+                                     GATE_REG l00, GATE_REG l10,
+                                     GATE_REG l11 )
+{
+    __m128 Wx, Wy;
+
+    Wx = _mm_div_ps( _mm_sub_ps( x, px ), l00 );
+    Wy = _mm_div_ps( _mm_sub_ps( _mm_sub_ps( y, py ), _mm_mul_ps( l10, Wx ) ),
+                     l11 );
+    return _mm_add_ps( _mm_mul_ps( Wx, Wx ), _mm_mul_ps( Wy, Wy ) );
+}
+
+static inline int gateMask( GATE_REG d, GATE_REG max )
+{
+    return _mm_movemask_ps( _mm_cmpngt_ps( d, max ) );
+}
+
+static inline void gateStore( MHT_REAL *dst, GATE_REG a )
+{
+    _mm_storeu_ps( dst, a );
+}
+
+#elif defined( __SSE2__ )
+
+typedef __m128d GATE_REG;
+enum { GATE_LANES = 2 };
+
+static inline GATE_REG gateSet1( MHT_REAL val )
+{
+    return _mm_set1_pd( val );
+}
+
+static inline GATE_REG gateLoad( const MHT_REAL *src )
+{
+    return _mm_loadu_pd( src );
+}
+
+static inline GATE_REG gateDistance( GATE_REG x, GATE_REG y,
+                                     GATE_REG px, GATE_REG py,
+                                     GATE_REG l00, GATE_REG l10,
+                                     GATE_REG l11 )
+{
+    __m128d Wx, Wy;
+
+    Wx = _mm_div_pd( _mm_sub_pd( x, px ), l00 );
+    Wy = _mm_div_pd( _mm_sub_pd( _mm_sub_pd( y, py ), _mm_mul_pd( l10, Wx ) ),
+                     l11 );
+    return _mm_add_pd( _mm_mul_pd( Wx, Wx ), _mm_mul_pd( Wy, Wy ) );
+}
+
+static inline int gateMask( GATE_REG d, GATE_REG max )
+{
+    return _mm_movemask_pd( _mm_cmpngt_pd( d, max ) );
+}
+
+static inline void gateStore( MHT_REAL *dst, GATE_REG a )
+{
+    _mm_storeu_pd( dst, a );
+}
+
+#else
+
+typedef MHT_REAL GATE_REG;
+enum { GATE_LANES = 1 };
+
+#endif
+
+/*-------------------------------------------------------------------*
+ | GateReports2D() -- find the reports inside a validation gate
+ *-------------------------------------------------------------------*/
+
+int GateReports2D( MHT_REAL px, MHT_REAL py,
+                   const MHT_REAL *sChol,
+                   MHT_REAL maxDistance,
+                   const MHT_REAL *x, const MHT_REAL *y,
+                   int numReports,
+                   int *passed, MHT_REAL *distance )
+{
+
+
+    MHT_REAL l00 = sChol[ 0 ], l10 = sChol[ 1 ], l11 = sChol[ 2 ];
+    MHT_REAL wx, wy;
+    MHT_REAL d;
+    int numPassed;
+    int i;
+
+    numPassed = 0;
+    i = 0;
+
+#if defined( __AVX__ ) || defined( __SSE2__ )
+
+    {
+        GATE_REG Px = gateSet1( px ), Py = gateSet1( py );
+        GATE_REG L00 = gateSet1( l00 ), L10 = gateSet1( l10 );
+        GATE_REG L11 = gateSet1( l11 );
+        GATE_REG Max = gateSet1( maxDistance );
+        GATE_REG D;
+        MHT_REAL dBuf[ GATE_LANES ];
+        int mask;
+        int k;
+
+        for( ; i + GATE_LANES <= numReports; i += GATE_LANES )
+        {
+            D = gateDistance( gateLoad( x + i ), gateLoad( y + i ),
+                              Px, Py, L00, L10, L11 );
+
+            mask = gateMask( D, Max );
+            if( mask == 0 )
+            {
+                continue;
+            }
+
+            gateStore( dBuf, D );
+            for( k = 0; k < GATE_LANES; k++ )
+                if( mask & (1 << k) )
+                {
+                    passed[ numPassed ] = i + k;
+                    distance[ numPassed ] = dBuf[ k ];
+                    numPassed++;
+                }
+        }
+    }
+
+#endif
+
+    /* whatever's left over (or everything, without SIMD) */
+    for( ; i < numReports; i++ )
+    {
+        wx = (x[ i ] - px) / l00;
+        wy = ((y[ i ] - py) - l10 * wx) / l11;
+        d = wx * wx + wy * wy;
+
+        if( d > maxDistance )
+        {
+            continue;
+        }
+
+        passed[ numPassed ] = i;
+        distance[ numPassed ] = d;
+        numPassed++;
+    }
+
+    return numPassed;
+}
+
+/*-------------------------------------------------------------------*
+ | CORR_REG -- a vector register of window sums, with the operations
+ |             the correlation kernel needs
+ *-------------------------------------------------------------------*/
+
+#if defined( __AVX__ )
+
+typedef __m256d CORR_REG;
+enum { CORR_LANES = 4 };
+
+static inline CORR_REG regSet1( double val )
+{
+    return _mm256_set1_pd( val );
+}
+
+static inline CORR_REG regMulAdd( CORR_REG sum, CORR_REG a,
+                                  const double *b )
+{
+    return _mm256_add_pd( sum, _mm256_mul_pd( a, _mm256_loadu_pd( b ) ) );
+}
+
+static inline CORR_REG regMax( CORR_REG a, CORR_REG b )
+{
+    return _mm256_max_pd( a, b );
+}
+
+static inline void regStore( double *dst, CORR_REG a )
+{
+    _mm256_storeu_pd( dst, a );
+}
+
+/* lanes where the sum and the product of the sigmas are both 0 get 1,
+   and ordered comparisons make a NaN out of range */
+static inline CORR_REG regNormalize( CORR_REG sum,
+                                     const double *windowSigma,
+                                     CORR_REG pSigma, CORR_REG numPixels,
+                                     int *inRange )
+{
+    __m256d Zero = _mm256_setzero_pd();
+    __m256d One = _mm256_set1_pd( 1. );
+    __m256d MinusOne = _mm256_set1_pd( -1. );
+    __m256d WSigma = _mm256_loadu_pd( windowSigma );
+    __m256d Corr;
+
+    Corr = _mm256_blendv_pd(
+               One,
+               _mm256_div_pd( sum,
+                              _mm256_mul_pd( _mm256_mul_pd( numPixels,
+                                                            WSigma ),
+                                             pSigma ) ),
+               _mm256_or_pd( _mm256_cmp_pd( sum, Zero, _CMP_NEQ_UQ ),
+                             _mm256_cmp_pd( _mm256_mul_pd( WSigma, pSigma ),
+                                            Zero, _CMP_NEQ_UQ ) ) );
+
+    if( _mm256_movemask_pd(
+            _mm256_and_pd( _mm256_cmp_pd( Corr, MinusOne, _CMP_GE_OQ ),
+                           _mm256_cmp_pd( Corr, One, _CMP_LE_OQ ) ) )
+        != 0xf )
+    {
+        *inRange = 0;
+    }
+
+    return Corr;
+}
+
+#elif defined( __SSE2__ )
+
+typedef __m128d CORR_REG;
+enum { CORR_LANES = 2 };
+
+static inline CORR_REG regSet1( double val )
+{
+    return _mm_set1_pd( val );
+}
+
+static inline CORR_REG regMulAdd( CORR_REG sum, CORR_REG a,
+                                  const double *b )
+{
+    return _mm_add_pd( sum, _mm_mul_pd( a, _mm_loadu_pd( b ) ) );
+}
+
+static inline CORR_REG regMax( CORR_REG a, CORR_REG b )
+{
+    return _mm_max_pd( a, b );
+}
+
+static inline void regStore( double *dst, CORR_REG a )
+{
+    _mm_storeu_pd( dst, a );
+}
+
+static inline CORR_REG regNormalize( CORR_REG sum,
+                                     const double *windowSigma,
+                                     CORR_REG pSigma, CORR_REG numPixels,
+                                     int *inRange )
+{
+    __m128d Zero = _mm_setzero_pd();
+    __m128d One = _mm_set1_pd( 1. );
+    __m128d MinusOne = _mm_set1_pd( -1. );
+    __m128d WSigma = _mm_loadu_pd( windowSigma );
+    __m128d Corr, Use;
+
+    Corr = _mm_div_pd( sum,
+                       _mm_mul_pd( _mm_mul_pd( numPixels, WSigma ), pSigma ) );
+    Use = _mm_or_pd( _mm_cmpneq_pd( sum, Zero ),
+                     _mm_cmpneq_pd( _mm_mul_pd( WSigma, pSigma ), Zero ) );
+    Corr = _mm_or_pd( _mm_and_pd( Use, Corr ),
+                      _mm_andnot_pd( Use, One ) );
+
+    if( _mm_movemask_pd( _mm_and_pd( _mm_cmpge_pd( Corr, MinusOne ),
+                                     _mm_cmple_pd( Corr, One ) ) ) != 0x3 )
+    {
+        *inRange = 0;
+    }
+
+    return Corr;
+}
+
+#else
+
+typedef double CORR_REG;
+enum { CORR_LANES = 1 };
+
+static inline CORR_REG regSet1( double val )
+{
+    return val;
+}
+
+static inline CORR_REG regMulAdd( CORR_REG sum, CORR_REG a,
+                                  const double *b )
+{
+    return sum + a * *b;
+}
+
+static inline CORR_REG regMax( CORR_REG a, CORR_REG b )
+{
+    return b > a ? b : a;
+}
+
+static inline void regStore( double *dst, CORR_REG a )
+{
+    *dst = a;
+}
+
+static inline CORR_REG regNormalize( CORR_REG sum,
+                                     const double *windowSigma,
+                                     CORR_REG pSigma, CORR_REG numPixels,
+                                     int *inRange )
+{
+    double corr;
+
+    corr = sum != 0.0 || *windowSigma * pSigma != 0.0 ?
+           sum / (numPixels * *windowSigma * pSigma) :
+           1.0;
+    if( ! (corr >= -1.0 && corr <= 1.0) )
+    {
+        *inRange = 0;
+    }
+
+    return corr;
+}
+
+#endif
+
+/*-------------------------------------------------------------------*
+ | normalizeCorr() -- turn the sum of products for one window into a
+ |                    correlation coefficient
+ *-------------------------------------------------------------------*/
+
+static inline double normalizeCorr( double sum, double windowSigma,
+                                    double patternSigma, int numPixels )
+{
+    return sum != 0.0 || windowSigma * patternSigma != 0.0 ?
+           sum / ((double)numPixels * windowSigma * patternSigma) :
+           1.0;
+}
+
+/*-------------------------------------------------------------------*
+ | corrPatch() -- find the correlations for one patch, with the
+ |                pattern already broadcast into registers
+ |
+ | The windows are covered by NUM_REGS registers, plus NUM_LEFT
+ | windows at the end that don't fill a register and are summed on
+ | their own.
+ *-------------------------------------------------------------------*/
+
+template< int templateRadius, int patchRadius >
+static inline int corrPatch( const CORR_REG *pattern,
+                             const double *patternDev,
+                             double patternSigma,
+                             const double *windowDev,
+                             const double *windowSigma,
+                             double *maxCorr )
+{
+    typedef TEXTURE_WINDOWS< templateRadius, patchRadius > SIZES;
+    enum
+    {
+        NUM_PIXELS = SIZES::NUM_PIXELS,
+        NUM_WINDOWS = SIZES::NUM_WINDOWS,
+        NUM_REGS = NUM_WINDOWS / CORR_LANES,
+        NUM_LEFT = NUM_WINDOWS % CORR_LANES
+    };
+
+    CORR_REG Sum[ NUM_REGS ];
+    CORR_REG PSigma = regSet1( patternSigma );
+    CORR_REG NumPixels = regSet1( (double)NUM_PIXELS );
+    CORR_REG Max;
+    double sumLeft[ NUM_LEFT + 1 ];
+    double corr;
+    double buf[ CORR_LANES ];
+    int inRange;
+    int k, v, w;
+
+    for( v = 0; v < NUM_REGS; v++ )
+    {
+        Sum[ v ] = regSet1( 0.0 );
+    }
+    for( w = 0; w < NUM_LEFT; w++ )
+    {
+        sumLeft[ w ] = 0.0;
+    }
+
+    for( k = 0; k < NUM_PIXELS; k++ )
+    {
+        for( v = 0; v < NUM_REGS; v++ )
+        {
+            Sum[ v ] = regMulAdd( Sum[ v ], pattern[ k ],
+                                  windowDev + k * NUM_WINDOWS +
+                                  v * CORR_LANES );
+        }
+        for( w = 0; w < NUM_LEFT; w++ )
+        {
+            sumLeft[ w ] += patternDev[ k ] *
+                            windowDev[ k * NUM_WINDOWS +
+                                       NUM_REGS * CORR_LANES + w ];
+        }
+    }
+
+    inRange = 1;
+    Max = regNormalize( Sum[ 0 ], windowSigma, PSigma, NumPixels,
+                        &inRange );
+    for( v = 1; v < NUM_REGS; v++ )
+    {
+        Max = regMax( Max,
+                      regNormalize( Sum[ v ], windowSigma + v * CORR_LANES,
+                                    PSigma, NumPixels, &inRange ) );
+    }
+
+    regStore( buf, Max );
+    *maxCorr = buf[ 0 ];
+    for( w = 1; w < CORR_LANES; w++ )
+        if( buf[ w ] > *maxCorr )
+        {
+            *maxCorr = buf[ w ];
+        }
+
+    for( w = 0; w < NUM_LEFT; w++ )
+    {
+        corr = normalizeCorr( sumLeft[ w ],
+                              windowSigma[ NUM_REGS * CORR_LANES + w ],
+                              patternSigma, NUM_PIXELS );
+        if( ! (corr >= -1.0 && corr <= 1.0) )
+        {
+            inRange = 0;
+        }
+        if( corr > *maxCorr )
+        {
+            *maxCorr = corr;
+        }
+    }
+
+    return inRange;
+}
+
+/*-------------------------------------------------------------------*
+ | TextureCorr() -- find the best correlation of a pattern with the
+ |                  windows of one patch
+ *-------------------------------------------------------------------*/
+
+template< int templateRadius, int patchRadius >
+int TextureCorr( const double *patternDev,
+                 double patternSigma,
+                 const double *windowDev,
+                 const double *windowSigma,
+                 double *maxCorr )
+{
+
+
+    enum { NUM_PIXELS =
+               TEXTURE_WINDOWS< templateRadius, patchRadius >::NUM_PIXELS };
+    CORR_REG pattern[ NUM_PIXELS ];
+    int k;
+
+    for( k = 0; k < NUM_PIXELS; k++ )
+    {
+        pattern[ k ] = regSet1( patternDev[ k ] );
+    }
+
+    return corrPatch< templateRadius, patchRadius >(
+               pattern, patternDev, patternSigma,
+               windowDev, windowSigma, maxCorr );
+}
+
+/*-------------------------------------------------------------------*
+ | TextureCorrBatch() -- find the best correlations of a pattern with
+ |                       the windows of several patches
+ *-------------------------------------------------------------------*/
+
+template< int templateRadius, int patchRadius >
+int TextureCorrBatch( const double *patternDev,
+                      double patternSigma,
+                      const double *const *windowDevs,
+                      const double *const *windowSigmas,
+                      int numPatches,
+                      double *maxCorr )
+{
+
+
+    enum { NUM_PIXELS =
+               TEXTURE_WINDOWS< templateRadius, patchRadius >::NUM_PIXELS };
+    CORR_REG pattern[ NUM_PIXELS ];
+    int inRange;
+    int i, k;
+
+    for( k = 0; k < NUM_PIXELS; k++ )
+    {
+        pattern[ k ] = regSet1( patternDev[ k ] );
+    }
+
+    inRange = 1;
+    for( i = 0; i < numPatches; i++ )
+    {
+        if( ! corrPatch< templateRadius, patchRadius >(
+                  pattern, patternDev, patternSigma,
+                  windowDevs[ i ], windowSigmas[ i ],
+                  &maxCorr[ i ] ) )
+        {
+            inRange = 0;
+        }
+    }
+
+    return inRange;
+}
+
+/*-------------------------------------------------------------------*
+ | The sizes there are kernels for
+ *-------------------------------------------------------------------*/
+
+#define INSTANTIATE_TEXTURE_CORR( templateRadius, patchRadius )       \
+    template int TextureCorr< templateRadius, patchRadius >(          \
+        const double *, double, const double *, const double *,       \
+        double * );                                                   \
+    template int TextureCorrBatch< templateRadius, patchRadius >(     \
+        const double *, double, const double *const *,                \
+        const double *const *, int, double * );
+
+INSTANTIATE_TEXTURE_CORR( 1, 2 )        // 3x3 in 5x5
+INSTANTIATE_TEXTURE_CORR( 2, 3 )        // 5x5 in 7x7
+INSTANTIATE_TEXTURE_CORR( 3, 4 )        // 7x7 in 9x9
@@ -0,0 +1,159 @@
+/*********************************************************************
+ * FILE: gate.H                                                      *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Batched validation gating of 2D position reports, and of their  *
+ *   texture patches.                                                *
+ *                                                                   *
+ *     int GateReports2D( MHT_REAL px, MHT_REAL py,                  *
+ *                        const MHT_REAL *sChol,                     *
+ *                        MHT_REAL maxDistance,                      *
+ *                        const MHT_REAL *x, const MHT_REAL *y,      *
+ *                        int numReports,                            *
+ *                        int *passed, MHT_REAL *distance )          *
+ *                                                                   *
+ *       Test numReports reported positions, given as separate       *
+ *       arrays of x and y coordinates, against one predicted        *
+ *       position (px, py).  sChol points to the Cholesky factor L   *
+ *       of the innovation covariance S = L L', given as L( 0, 0 ),  *
+ *       L( 1, 0 ) and L( 1, 1 ) (as in FIXED_CHOLESKY< 2 >::        *
+ *       getData()).  A report passes unless its Mahalanobis         *
+ *       distance                                                    *
+ *                                                                   *
+ *         v' S.inv() v,   v = (x[ i ] - px, y[ i ] - py)'           *
+ *                                                                   *
+ *       is greater than maxDistance.  The indices of the reports    *
+ *       that pass are put into passed[], in increasing order, with  *
+ *       their distances in the corresponding entries of distance[]. *
+ *       Both arrays need room for numReports entries.  The number   *
+ *       of reports that passed is returned.                         *
+ *                                                                   *
+ *   The texture comparisons are templates on the radius of the      *
+ *   template (the pattern being looked for) and of the patch it's   *
+ *   looked for in.  TEXTURE_WINDOWS< templateRadius, patchRadius >  *
+ *   gives their sizes:                                              *
+ *                                                                   *
+ *     NUM_PIXELS   pixels in the template, and in each window       *
+ *     NUM_WINDOWS  windows of the template's size in the patch      *
+ *     NUM_SHIFTS   windows along each side of the patch             *
+ *     CENTER_WINDOW  the window in the middle of the patch          *
+ *                                                                   *
+ *   Window w is centered on row w / NUM_SHIFTS + templateRadius,    *
+ *   column w % NUM_SHIFTS + templateRadius of the patch.            *
+ *                                                                   *
+ *     template< int templateRadius, int patchRadius >               *
+ *     int TextureCorr( const double *patternDev,                    *
+ *                      double patternSigma,                         *
+ *                      const double *windowDev,                     *
+ *                      const double *windowSigma,                   *
+ *                      double *maxCorr )                            *
+ *                                                                   *
+ *       Find the largest normalized cross-correlation between a     *
+ *       pattern and the windows of a patch.  The pattern is given   *
+ *       by its NUM_PIXELS pixels minus their mean, row by row, and  *
+ *       by their standard deviation.  The windows are given the     *
+ *       same way, except that windowDev[ k * NUM_WINDOWS + w ] is   *
+ *       pixel k of window w, so that the pixels at the same place   *
+ *       in all the windows are together.  The correlation with      *
+ *       window w is                                                 *
+ *                                                                   *
+ *         sum( patternDev[ k ] * windowDev[ k * NUM_WINDOWS + w ] ) *
+ *           / (NUM_PIXELS * windowSigma[ w ] * patternSigma)        *
+ *                                                                   *
+ *       or 1 if the sum and the product of the sigmas are both 0.   *
+ *       The largest is put in *maxCorr.  1 is returned if all of    *
+ *       them are between -1 and 1, which they are unless something  *
+ *       is wrong with the statistics, and 0 otherwise.              *
+ *                                                                   *
+ *     template< int templateRadius, int patchRadius >               *
+ *     int TextureCorrBatch( const double *patternDev,               *
+ *                           double patternSigma,                    *
+ *                           const double *const *windowDevs,        *
+ *                           const double *const *windowSigmas,      *
+ *                           int numPatches,                         *
+ *                           double *maxCorr )                       *
+ *                                                                   *
+ *       The same, for one pattern against numPatches patches, whose *
+ *       statistics are pointed to by windowDevs[ i ] and            *
+ *       windowSigmas[ i ].  Their largest correlations go into      *
+ *       maxCorr[ i ].  1 is returned if every correlation is in     *
+ *       range.                                                      *
+ *                                                                   *
+ *   gate.C instantiates these for a 3x3 template in a 5x5 patch     *
+ *   (radii 1 and 2), 5x5 in 7x7 (2 and 3) and 7x7 in 9x9 (3 and 4). *
+ *   Other sizes need another line at the end of gate.C.             *
+ *                                                                   *
+ * IMPLEMENTATION NOTES:                                             *
+ *                                                                   *
+ *   The distance is worked out by solving L w = v and taking the    *
+ *   squared length of w, with the same operations, in the same      *
+ *   order, as FIXED_CHOLESKY< 2 >::mahalanobis() (see matrix.H), so *
+ *   the distances are identical to the ones a model computes that   *
+ *   way, and a report that fails here would fail there too.  (This  *
+ *   assumes the compiler isn't allowed to fuse multiplies and adds, *
+ *   which is the case unless FMA instructions are enabled.)  A NaN  *
+ *   distance passes, as it does with "distance > maxDistance".      *
+ *                                                                   *
+ *   The arithmetic is done in MHT_REAL's (see precision.H).  Four   *
+ *   reports at a time are done with AVX when the compiler targets   *
+ *   it, two at a time with SSE2 otherwise, and one at a time when   *
+ *   neither is available.  In single precision twice as many fit in *
+ *   a register, so it's eight with AVX and four with SSE2.          *
+ *                                                                   *
+ *   The correlations are done the same way, with the windows spread *
+ *   across vector lanes (four per AVX vector, two per SSE2 vector,  *
+ *   and any left over on their own), so that each window's sum is   *
+ *   accumulated in a single lane in the same order as the scalar    *
+ *   sum.  The results are identical to those of the obvious loop.   *
+ *   All the loop counts are compile-time constants, so each         *
+ *   instantiation is a straight-line kernel for its sizes once the  *
+ *   compiler unrolls it.  The batch form broadcasts the pattern     *
+ *   into registers once for all the patches.                        *
+ *                                                                   *
+ *   "make gatecheck" checks all of this: it builds gatecheck.C,     *
+ *   which compares each kernel with the obvious loop, for every     *
+ *   instruction set and precision, and runs it.                     *
+ *                                                                   *
+ *********************************************************************/
+
+#ifndef GATE_H
+#define GATE_H
+
+#include "precision.h"
+
+int GateReports2D( MHT_REAL px, MHT_REAL py,
+                   const MHT_REAL *sChol,
+                   MHT_REAL maxDistance,
+                   const MHT_REAL *x, const MHT_REAL *y,
+                   int numReports,
+                   int *passed, MHT_REAL *distance );
+
+template< int templateRadius, int patchRadius >
+struct TEXTURE_WINDOWS
+{
+    enum
+    {
+        NUM_PIXELS = (2 * templateRadius + 1) * (2 * templateRadius + 1),
+        NUM_SHIFTS = 2 * (patchRadius - templateRadius) + 1,
+        NUM_WINDOWS = NUM_SHIFTS * NUM_SHIFTS,
+        CENTER_WINDOW = NUM_WINDOWS / 2
+    };
+};
+
+template< int templateRadius, int patchRadius >
+int TextureCorr( const double *patternDev,
+                 double patternSigma,
+                 const double *windowDev,
+                 const double *windowSigma,
+                 double *maxCorr );
+
+template< int templateRadius, int patchRadius >
+int TextureCorrBatch( const double *patternDev,
+                      double patternSigma,
+                      const double *const *windowDevs,
+                      const double *const *windowSigmas,
+                      int numPatches,
+                      double *maxCorr );
+
+#endif
@@ -0,0 +1,393 @@
+/*********************************************************************
+ * FILE: gatecheck.C                                                 *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   A check that the kernels in gate.C give exactly what the        *
+ *   obvious loops give.  GateReports2D() and every instantiation    *
+ *   of TextureCorr<>() and TextureCorrBatch<>() are run on          *
+ *   pseudo-random data, with the awkward cases mixed in (leftover   *
+ *   reports and windows that don't fill a register, NaN             *
+ *   positions, flat windows, statistics that put a correlation out  *
+ *   of range), and compared with scalar reference loops written     *
+ *   out here.  Any difference is printed, and the exit status is    *
+ *   1 if there was one.                                             *
+ *                                                                   *
+ *   gate.C picks its SIMD paths from the compiler's target, so this *
+ *   has to be built once per instruction set.  "make gatecheck"     *
+ *   (see makefile) builds and runs it without SIMD, with SSE2 and   *
+ *   with AVX, in double and in single precision.                    *
+ *                                                                   *
+ *********************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gate.h"
+
+/*-------------------------------------------------------------------*
+ | Random numbers -- a fixed linear congruential generator, so every
+ | build checks the same cases
+ *-------------------------------------------------------------------*/
+
+static unsigned long g_seed = 12345;
+
+static double Uniform( double lo, double hi )
+{
+    g_seed = (g_seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+    return lo + (hi - lo) * (double)g_seed / (double)0x7fffffffUL;
+}
+
+static int g_numCases = 0;
+static int g_numDiffs = 0;
+
+static void Differ( const char *what, int caseNum, int i,
+                    double got, double expected )
+{
+    if( g_numDiffs++ < 20 )
+    {
+        printf( "  %s, case %d, entry %d: got %.17g, expected %.17g\n",
+                what, caseNum, i, got, expected );
+    }
+}
+
+static int SameValue( double a, double b )
+{
+    return a == b || (isnan( a ) && isnan( b ));
+}
+
+/*-------------------------------------------------------------------*
+ | RefGateReports2D() -- the scalar loop that GateReports2D() must
+ |                       match
+ *-------------------------------------------------------------------*/
+
+static int RefGateReports2D( MHT_REAL px, MHT_REAL py,
+                             const MHT_REAL *sChol,
+                             MHT_REAL maxDistance,
+                             const MHT_REAL *x, const MHT_REAL *y,
+                             int numReports,
+                             int *passed, MHT_REAL *distance )
+{
+
+
+    MHT_REAL wx, wy, d;
+    int numPassed;
+    int i;
+
+    numPassed = 0;
+    for( i = 0; i < numReports; i++ )
+    {
+        wx = (x[ i ] - px) / sChol[ 0 ];
+        wy = ((y[ i ] - py) - sChol[ 1 ] * wx) / sChol[ 2 ];
+        d = wx * wx + wy * wy;
+        if( ! (d > maxDistance) )
+        {
+            passed[ numPassed ] = i;
+            distance[ numPassed ] = d;
+            numPassed++;
+        }
+    }
+
+    return numPassed;
+}
+
+/*-------------------------------------------------------------------*
+ | CheckGate() -- compare GateReports2D() with the reference for
+ |                every number of reports up to 40, and a few big
+ |                ones
+ *-------------------------------------------------------------------*/
+
+static void CheckGate()
+{
+
+
+    enum { MAX_REPORTS = 1000 };
+    static MHT_REAL x[ MAX_REPORTS ], y[ MAX_REPORTS ];
+    static MHT_REAL distance[ MAX_REPORTS ], refDistance[ MAX_REPORTS ];
+    static int passed[ MAX_REPORTS ], refPassed[ MAX_REPORTS ];
+    MHT_REAL sChol[ 3 ];
+    MHT_REAL px, py, maxDistance;
+    int numReports, numPassed, refNumPassed;
+    int caseNum;
+    int i;
+
+    for( caseNum = 0; caseNum < 200; caseNum++ )
+    {
+        numReports = caseNum < 41 ? caseNum :
+                     caseNum < 190 ? (int)Uniform( 0., 64. ) :
+                     MAX_REPORTS - (caseNum - 190);
+
+        px = (MHT_REAL)Uniform( 0., 512. );
+        py = (MHT_REAL)Uniform( 0., 512. );
+        sChol[ 0 ] = (MHT_REAL)Uniform( 1., 10. );
+        sChol[ 1 ] = (MHT_REAL)Uniform( -5., 5. );
+        sChol[ 2 ] = (MHT_REAL)Uniform( 1., 10. );
+        maxDistance = (MHT_REAL)Uniform( 1., 50. );
+
+        for( i = 0; i < numReports; i++ )
+        {
+            x[ i ] = (MHT_REAL)(px + Uniform( -20., 20. ));
+            y[ i ] = (MHT_REAL)(py + Uniform( -20., 20. ));
+            if( Uniform( 0., 1. ) < 0.05 )
+            {
+                x[ i ] = (MHT_REAL)NAN;
+            }
+        }
+
+        numPassed = GateReports2D( px, py, sChol, maxDistance, x, y,
+                                   numReports, passed, distance );
+        refNumPassed = RefGateReports2D( px, py, sChol, maxDistance, x, y,
+                                         numReports,
+                                         refPassed, refDistance );
+        g_numCases++;
+
+        if( numPassed != refNumPassed )
+        {
+            Differ( "GateReports2D count", caseNum, 0,
+                    numPassed, refNumPassed );
+            continue;
+        }
+        for( i = 0; i < numPassed; i++ )
+        {
+            if( passed[ i ] != refPassed[ i ] )
+            {
+                Differ( "GateReports2D index", caseNum, i,
+                        passed[ i ], refPassed[ i ] );
+            }
+            else if( ! SameValue( distance[ i ], refDistance[ i ] ) )
+            {
+                Differ( "GateReports2D distance", caseNum, i,
+                        distance[ i ], refDistance[ i ] );
+            }
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | RefTextureCorr() -- the loop that TextureCorr<>() must match
+ *-------------------------------------------------------------------*/
+
+template< int templateRadius, int patchRadius >
+static int RefTextureCorr( const double *patternDev,
+                           double patternSigma,
+                           const double *windowDev,
+                           const double *windowSigma,
+                           double *maxCorr )
+{
+
+
+    typedef TEXTURE_WINDOWS< templateRadius, patchRadius > SIZES;
+    double sum, corr;
+    int inRange;
+    int k, w;
+
+    inRange = 1;
+    *maxCorr = -HUGE_VAL;
+    for( w = 0; w < SIZES::NUM_WINDOWS; w++ )
+    {
+        sum = 0.0;
+        for( k = 0; k < SIZES::NUM_PIXELS; k++ )
+        {
+            sum += patternDev[ k ] * windowDev[ k * SIZES::NUM_WINDOWS + w ];
+        }
+
+        corr = sum != 0.0 || windowSigma[ w ] * patternSigma != 0.0 ?
+               sum / ((double)SIZES::NUM_PIXELS * windowSigma[ w ] *
+                      patternSigma) :
+               1.0;
+        if( ! (corr >= -1.0 && corr <= 1.0) )
+        {
+            inRange = 0;
+        }
+        if( corr > *maxCorr )
+        {
+            *maxCorr = corr;
+        }
+    }
+
+    return inRange;
+}
+
+/*-------------------------------------------------------------------*
+ | MakePatch() -- make the window statistics of a random patch, the
+ |                way CONSTPOS_REPORT does
+ |
+ | kind 1 makes one window flat (all deviations and its sigma 0),
+ | kind 2 understates one window's sigma, so its correlation can
+ | come out of range, and kind 3 gives one window a sigma of 0
+ | without making it flat.  kind 4 uses deviations of -1, 0 and 1,
+ | so that with a pattern made the same way some sums are exactly
+ | 0.
+ *-------------------------------------------------------------------*/
+
+template< int templateRadius, int patchRadius >
+static void MakePatch( double *windowDev, double *windowSigma, int kind )
+{
+
+
+    typedef TEXTURE_WINDOWS< templateRadius, patchRadius > SIZES;
+    double sumSq;
+    int k, w;
+
+    for( w = 0; w < SIZES::NUM_WINDOWS; w++ )
+    {
+        sumSq = 0.0;
+        for( k = 0; k < SIZES::NUM_PIXELS; k++ )
+        {
+            windowDev[ k * SIZES::NUM_WINDOWS + w ] =
+                kind == 4 ? floor( Uniform( -1., 1.999 ) ) :
+                Uniform( -100., 100. );
+            sumSq += windowDev[ k * SIZES::NUM_WINDOWS + w ] *
+                     windowDev[ k * SIZES::NUM_WINDOWS + w ];
+        }
+        windowSigma[ w ] = sqrt( sumSq / SIZES::NUM_PIXELS );
+    }
+
+    w = (int)Uniform( 0., SIZES::NUM_WINDOWS - 0.5 );
+    if( kind == 1 )
+    {
+        for( k = 0; k < SIZES::NUM_PIXELS; k++ )
+        {
+            windowDev[ k * SIZES::NUM_WINDOWS + w ] = 0.0;
+        }
+        windowSigma[ w ] = 0.0;
+    }
+    else if( kind == 2 )
+    {
+        windowSigma[ w ] *= 0.01;
+    }
+    else if( kind == 3 )
+    {
+        windowSigma[ w ] = 0.0;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | CheckTexture<>() -- compare TextureCorr<>() and TextureCorrBatch<>()
+ |                     for one size with the reference
+ *-------------------------------------------------------------------*/
+
+template< int templateRadius, int patchRadius >
+static void CheckTexture( const char *name )
+{
+
+
+    typedef TEXTURE_WINDOWS< templateRadius, patchRadius > SIZES;
+    enum { MAX_PATCHES = 9 };
+    double patternDev[ SIZES::NUM_PIXELS ];
+    double patternSigma;
+    double windowDev[ MAX_PATCHES ][ SIZES::NUM_PIXELS * SIZES::NUM_WINDOWS ];
+    double windowSigma[ MAX_PATCHES ][ SIZES::NUM_WINDOWS ];
+    const double *windowDevs[ MAX_PATCHES ];
+    const double *windowSigmas[ MAX_PATCHES ];
+    double maxCorr, refMaxCorr;
+    double batchMaxCorr[ MAX_PATCHES ];
+    double refMaxCorrs[ MAX_PATCHES ];
+    char what[ 80 ];
+    int inRange, refInRange, batchInRange, allInRange;
+    double sumSq;
+    int numPatches;
+    int caseNum;
+    int i, k;
+
+    for( caseNum = 0; caseNum < 100; caseNum++ )
+    {
+        sumSq = 0.0;
+        for( k = 0; k < SIZES::NUM_PIXELS; k++ )
+        {
+            patternDev[ k ] = caseNum % 5 == 4 ?
+                              floor( Uniform( -1., 1.999 ) ) :
+                              Uniform( -100., 100. );
+            sumSq += patternDev[ k ] * patternDev[ k ];
+        }
+        patternSigma = sqrt( sumSq / SIZES::NUM_PIXELS );
+
+        /* a flat pattern now and then, which makes every window with
+           a sigma of 0 correlate at 1 */
+        if( caseNum % 25 == 24 )
+        {
+            for( k = 0; k < SIZES::NUM_PIXELS; k++ )
+            {
+                patternDev[ k ] = 0.0;
+            }
+            patternSigma = 0.0;
+        }
+
+        numPatches = 1 + caseNum % MAX_PATCHES;
+        allInRange = 1;
+        for( i = 0; i < numPatches; i++ )
+        {
+            MakePatch< templateRadius, patchRadius >(
+                windowDev[ i ], windowSigma[ i ],
+                caseNum % 5 == 4 ? 4 : (caseNum + i) % 4 );
+            windowDevs[ i ] = windowDev[ i ];
+            windowSigmas[ i ] = windowSigma[ i ];
+
+            refInRange = RefTextureCorr< templateRadius, patchRadius >(
+                             patternDev, patternSigma,
+                             windowDev[ i ], windowSigma[ i ],
+                             &refMaxCorr );
+            inRange = TextureCorr< templateRadius, patchRadius >(
+                          patternDev, patternSigma,
+                          windowDev[ i ], windowSigma[ i ],
+                          &maxCorr );
+            g_numCases++;
+
+            sprintf( what, "TextureCorr< %s >", name );
+            if( inRange != refInRange )
+            {
+                Differ( what, caseNum, i, inRange, refInRange );
+            }
+            else if( inRange && ! SameValue( maxCorr, refMaxCorr ) )
+            {
+                Differ( what, caseNum, i, maxCorr, refMaxCorr );
+            }
+
+            refMaxCorrs[ i ] = refInRange ? refMaxCorr : NAN;
+            allInRange = allInRange && refInRange;
+        }
+
+        batchInRange = TextureCorrBatch< templateRadius, patchRadius >(
+                           patternDev, patternSigma,
+                           windowDevs, windowSigmas, numPatches,
+                           batchMaxCorr );
+        g_numCases++;
+
+        sprintf( what, "TextureCorrBatch< %s >", name );
+        if( batchInRange != allInRange )
+        {
+            Differ( what, caseNum, -1, batchInRange, allInRange );
+        }
+        for( i = 0; i < numPatches; i++ )
+        {
+            if( ! isnan( refMaxCorrs[ i ] ) &&
+                ! SameValue( batchMaxCorr[ i ], refMaxCorrs[ i ] ) )
+            {
+                Differ( what, caseNum, i, batchMaxCorr[ i ],
+                        refMaxCorrs[ i ] );
+            }
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | main() -- run all the checks
+ |
+ | The optional argument is a label for the build, for the output.
+ *-------------------------------------------------------------------*/
+
+int main( int argc, char **argv )
+{
+
+
+    CheckGate();
+    CheckTexture< 1, 2 >( "1, 2" );
+    CheckTexture< 2, 3 >( "2, 3" );
+    CheckTexture< 3, 4 >( "3, 4" );
+
+    printf( "gatecheck%s%s: %d cases, %d differences\n",
+            argc > 1 ? " " : "", argc > 1 ? argv[ 1 ] : "",
+            g_numCases, g_numDiffs );
+
+    return g_numDiffs == 0 ? 0 : 1;
+}
@@ -49,38 +49,181 @@
 void XMakeLinkBase( void *obj0, LINKSbase &links0,
                     void *obj1, LINKSbase &links1 )
 {
-    /* the following two nodes will be partners */
-    LINK_NODE *node0 = new LINK_NODE;
-    LINK_NODE *node1 = new LINK_NODE;
 
-    links0.m_list.prepend( node0 );
-    links1.m_list.prepend( node1 );
 
-    node0->m_thatObj = obj1;
-    node0->m_partner = node1;
+    LINK_EDGE edge0;
+    LINK_EDGE edge1;
 
-    node1->m_thatObj = obj0;
-    node1->m_partner = node0;
+    links0.compact();
+    links1.compact();
+
+    /* the following two edges will be partners (if the two sets of
+       links are the same, edge1 goes right after edge0) */
+    edge0.m_thatObj = obj1;
+    edge0.m_thatLinks = &links1;
+    edge0.m_thatIndex = links1.m_edges.size();
+    if( &links0 == &links1 )
+    {
+        edge0.m_thatIndex++;
+    }
+
+    edge1.m_thatObj = obj0;
+    edge1.m_thatLinks = &links0;
+    edge1.m_thatIndex = links0.m_edges.size();
+
+    links0.m_edges.push_back( edge0 );
+    links0.m_numLinks++;
+    links1.m_edges.push_back( edge1 );
+    links1.m_numLinks++;
+}
+
+/*-------------------------------------------------------------------*
+ | LINKSbase::removeAll() -- remove all the links
+ *-------------------------------------------------------------------*/
+
+void LINKSbase::removeAll()
+{
+
+
+    int i;
+
+    for( i = (int)m_edges.size() - 1; i >= 0 && m_numLinks > 0; i-- )
+    {
+        if( i < (int)m_edges.size() && m_edges[ i ].m_thatObj != 0 )
+        {
+            removeLink( i );
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | LINKSbase::getLength() -- get the number of links, and check it
+ |                           against the edges that aren't removed
+ |
+ | (Only if DEBUG is defined.)
+ *-------------------------------------------------------------------*/
+
+#ifdef DEBUG
+
+int LINKSbase::getLength() const
+{
+
+
+    int length;
+    int i;
+
+    length = 0;
+    for( i = 0; i < (int)m_edges.size(); i++ )
+    {
+        if( m_edges[ i ].m_thatObj != 0 )
+        {
+            length++;
+        }
+    }
+
+    assert( length == m_numLinks );
+
+    return m_numLinks;
+}
+
+#endif
+
+/*-------------------------------------------------------------------*
+ | LINKSbase::removeLink() -- remove the link whose edge is at index
+ *-------------------------------------------------------------------*/
+
+void LINKSbase::removeLink( int index )
+{
+
+
+    LINKSbase *thatLinks = m_edges[ index ].m_thatLinks;
+    int thatIndex = m_edges[ index ].m_thatIndex;
+
+#ifdef TSTBUG
+    assert( m_edges[ index ].m_thatObj != 0 );
+    assert( thatLinks->m_edges[ thatIndex ].m_thatLinks == this &&
+            thatLinks->m_edges[ thatIndex ].m_thatIndex == index );
+#endif
+
+    /* drop the later edge first, in case both are in this array and
+       dropping one of them shortens it */
+    if( thatLinks == this && thatIndex > index )
+    {
+        dropEdge( thatIndex );
+        dropEdge( index );
+    }
+    else
+    {
+        dropEdge( index );
+        thatLinks->dropEdge( thatIndex );
+    }
 }
 
 /*-------------------------------------------------------------------*
- | LINK_NODE::~LINK_NODE() -- destructor for LINK_NODE
+ | LINKSbase::dropEdge() -- mark one edge as removed
  |
- | Each LINK_NODE contains a pointer to the object that it links with
- | and a pointer to its partner.  When a LINK_NODE is deleted, it
- | must delete it's partner.  To avoid infinite recursion (the partner
- | trying to delete the node back), the pointer to the object is used
- | as a flag.  If the pointer is null when the destructor is called,
- | it means that the LINK_NODE is being deleted by its partner, and
- | shouldn't try to delete its partner back.
+ | Removed edges at the end of the array are popped off it, so that
+ | the last edge, if any, is always the head.
  *-------------------------------------------------------------------*/
 
-LINK_NODE::~LINK_NODE()
+void LINKSbase::dropEdge( int index )
 {
-    if( m_thatObj != 0 )
+
+
+    m_edges[ index ].m_thatObj = 0;
+    m_numLinks--;
+
+    if( m_numLinks == 0 )
+    {
+        m_edges.clear();
+        return;
+    }
+
+    while( m_edges.back().m_thatObj == 0 )
     {
-        m_partner->m_thatObj = 0;
-        delete m_partner;
+        m_edges.pop_back();
     }
 }
 
+/*-------------------------------------------------------------------*
+ | LINKSbase::compact() -- squeeze the removed edges out of the array,
+ |                         if there are more of them than links
+ |
+ | The partners of the edges that move are told their new indices.
+ | This moves edges, so it must not be called while a
+ | PTR_INTO_LINKS_TO<> might be looping through the array.  It's
+ | only called when a link is made.
+ *-------------------------------------------------------------------*/
+
+void LINKSbase::compact()
+{
+
+
+    static const int MIN_REMOVED = 8;
+    int size = m_edges.size();
+    int i, j;
+
+    if( size - m_numLinks < m_numLinks + MIN_REMOVED )
+    {
+        return;
+    }
+
+    j = 0;
+    for( i = 0; i < size; i++ )
+    {
+        if( m_edges[ i ].m_thatObj == 0 )
+        {
+            continue;
+        }
+
+        if( i != j )
+        {
+            m_edges[ j ] = m_edges[ i ];
+            m_edges[ j ].m_thatLinks->
+                m_edges[ m_edges[ j ].m_thatIndex ].m_thatIndex = j;
+        }
+        j++;
+    }
+
+    m_edges.resize( j );
+}
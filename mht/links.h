@@ -220,7 +220,9 @@
  *     Returns 1 if there is one and only one link, 0 if not.        *
  *                                                                   *
  *   int getLength() const                                           *
- *     Returns the number of links.                                  *
+ *     Returns the number of links.  This is a count kept as links   *
+ *     are made and removed.  If DEBUG is defined, the count is      *
+ *     checked against the links actually stored.                    *
  *                                                                   *
  *   void removeHead()                                               *
  *     Removes the first link.                                       *
@@ -360,12 +362,13 @@
 #include "except.h"
 #include "list.h"
 #include <assert.h>
+#include <vector>		// for std::vector<>
 
 /*-------------------------------------------------------------------*
  | Declarations of stuff found in this file.
  *-------------------------------------------------------------------*/
 
-class LINK_NODE;
+struct LINK_EDGE;
 class LINKSbase;
 class PTR_INTO_LINKSbase;
 
@@ -373,40 +376,28 @@ template< class TYPE > class LINKS_TO;
 template< class TYPE > class PTR_INTO_LINKS_TO;
 
 /*-------------------------------------------------------------------*
- | LINK_NODE -- representation of a link
+ | LINK_EDGE -- representation of one end of a link
  |
- | A LINKS_TO<> object is a list of LINK_NODEs.  Each link between
- | two objects is represented by two LINK_NODEs -- one link node in
- | one object's list, one in the other.  These two nodes are called
- | each other's "partners".
+ | A LINKS_TO<> object is an array of LINK_EDGEs, in the order the
+ | links were made (so its "head", the newest link, is at the end).
+ | Each link between two objects is represented by two LINK_EDGEs --
+ | one in one object's array, one in the other.  These two edges are
+ | called each other's "partners", and each one records where the
+ | other is.
+ |
+ | A removed link's edges are just marked, by setting m_thatObj to 0,
+ | so removing a link is quick and doesn't disturb any
+ | PTR_INTO_LINKS_TO<> that's looping through the array.  The marked
+ | edges are squeezed out when a new link is made, if there are many
+ | of them (see LINKSbase::compact()).
  *-------------------------------------------------------------------*/
 
-class LINK_NODE: public DLISTnode
+struct LINK_EDGE
 {
-    friend class LINKSbase;
-    friend class PTR_INTO_LINKSbase;
-    friend void XMakeLinkBase( void *obj0, LINKSbase &links0,
-                               void *obj1, LINKSbase &links1 );
-
-private:
-
-    void *m_thatObj;
-    LINK_NODE *m_partner;
-
-    LINK_NODE(): DLISTnode(), m_thatObj( 0 ), m_partner( 0 ) {}
-    LINK_NODE( const LINK_NODE & )
-    {
-        assert(false);
-        //THROW_ERR( "Trying to copy a LINK_NODE (don't know how)" )
-    }
-
-protected:
-
-    MEMBERS_FOR_DLISTnode( LINK_NODE )
-
-public:
-
-    ~LINK_NODE();
+    void *m_thatObj;                 // object linked to (0 if the
+                                     //   link has been removed)
+    LINKSbase *m_thatLinks;          // LINKS_TO<> holding the partner,
+    int m_thatIndex;                 //   and the partner's index in it
 };
 
 /*-------------------------------------------------------------------*
@@ -421,125 +412,214 @@ class LINKSbase
 
 private:
 
-    iDLIST_OF< LINK_NODE > m_list;
+    std::vector< LINK_EDGE > m_edges;
+    int m_numLinks;                  // edges not marked as removed
 
 protected:
 
-    LINKSbase(): m_list() {}
-    virtual ~LINKSbase() {}
+    LINKSbase(): m_edges(), m_numLinks( 0 ) {}
+
+    /* links can't be copied (an object that's copied starts out
+       with no links) */
+    LINKSbase( const LINKSbase &links ):
+        m_edges(),
+        m_numLinks( 0 )
+    {
+#ifdef TSTBUG
+        assert( links.isEmpty() );
+#endif
+    }
+
+    ~LINKSbase()
+    {
+        removeAll();
+    }
 
     void *baseGetHead() const
     {
-        return m_list.getHead()->m_thatObj;
+        return m_edges[ findHead() ].m_thatObj;
     }
     void *baseGetTail() const
     {
-        return m_list.getTail()->m_thatObj;
+        return m_edges[ findTail() ].m_thatObj;
     }
 
 public:
 
     int isEmpty() const
     {
-        return m_list.isEmpty();
+        return m_numLinks == 0;
     }
     int hasOneMember() const
     {
-        return m_list.hasOneMember();
+        return m_numLinks == 1;
     }
+#ifdef DEBUG
+    int getLength() const;
+#else
     int getLength() const
     {
-        return m_list.getLength();
+        return m_numLinks;
     }
+#endif
 
     void removeHead()
     {
-        m_list.removeHead();
+        removeLink( findHead() );
     }
     void removeTail()
     {
-        m_list.removeTail();
+        removeLink( findTail() );
     }
-    void removeAll()
+    void removeAll();
+
+private:
+
+    LINKSbase &operator=( const LINKSbase & );
+
+    /* the edge at the end is never a removed one (see dropEdge()) */
+    int findHead() const
     {
-        m_list.removeAll();
+#ifdef TSTBUG
+        assert( m_numLinks > 0 );
+#endif
+
+        return (int)m_edges.size() - 1;
     }
+    int findTail() const
+    {
+        int index = 0;
+
+#ifdef TSTBUG
+        assert( m_numLinks > 0 );
+#endif
+
+        while( m_edges[ index ].m_thatObj == 0 )
+        {
+            index++;
+        }
+
+        return index;
+    }
+
+    void removeLink( int index );
+    void dropEdge( int index );
+    void compact();
 };
 
 /*-------------------------------------------------------------------*
  | PTR_INTO_LINKSbase -- base class for all PTR_INTO_LINKS_TO<>
  |                       classes
+ |
+ | Moving to the next link means moving toward the start of the
+ | array, past any removed edges.
  *-------------------------------------------------------------------*/
 
 class PTR_INTO_LINKSbase
 {
 private:
 
-    PTR_INTO_iDLIST_OF< LINK_NODE > m_ptr;
+    LINKSbase *m_links;
+    int m_index;
 
 protected:
 
-    PTR_INTO_LINKSbase(): m_ptr() {}
-    PTR_INTO_LINKSbase( LINKSbase &links ): m_ptr( links.m_list ) {}
+    PTR_INTO_LINKSbase(): m_links( 0 ), m_index( -1 ) {}
+    PTR_INTO_LINKSbase( LINKSbase &links ):
+        m_links( 0 ),
+        m_index( -1 )
+    {
+        baseSet( links, START_AT_HEAD );
+    }
     PTR_INTO_LINKSbase( LINKSbase &links, START_AT_HEADversion ):
-        m_ptr( links.m_list, START_AT_HEAD )
+        m_links( 0 ),
+        m_index( -1 )
     {
+        baseSet( links, START_AT_HEAD );
     }
     PTR_INTO_LINKSbase( LINKSbase &links, START_AT_TAILversion ):
-        m_ptr( links.m_list, START_AT_TAIL )
+        m_links( 0 ),
+        m_index( -1 )
     {
+        baseSet( links, START_AT_TAIL );
     }
 
-    virtual ~PTR_INTO_LINKSbase() {}
-
     void baseSet( LINKSbase &links )
     {
-        m_ptr.set( links.m_list );
+        baseSet( links, START_AT_HEAD );
     }
     void baseSet( LINKSbase &links, START_AT_HEADversion )
     {
-        m_ptr.set( links.m_list, START_AT_HEAD );
+        m_links = &links;
+        m_index = (int)links.m_edges.size() - 1;
     }
     void baseSet( LINKSbase &links, START_AT_TAILversion )
     {
-        m_ptr.set( links.m_list, START_AT_TAIL );
+        m_links = &links;
+        m_index = links.isEmpty() ? 0 : links.findTail();
     }
 
     void *baseGet() const
     {
-        return (*m_ptr).m_thatObj;
+#ifdef TSTBUG
+        assert( isValid() );
+#endif
+
+        return m_links->m_edges[ m_index ].m_thatObj;
     }
 
 public:
 
     int isInitialized() const
     {
-        return m_ptr.isInitialized();
+        return m_links != 0;
     }
     int isValid() const
     {
-        return m_ptr.isValid();
+        return m_links != 0 &&
+               m_index >= 0 && m_index < (int)m_links->m_edges.size() &&
+               m_links->m_edges[ m_index ].m_thatObj != 0;
     }
     int isAtHead() const
     {
-        return m_ptr.isAtHead();
+        return isValid() &&
+               m_index == (int)m_links->m_edges.size() - 1;
     }
     int isAtTail() const
     {
-        return m_ptr.isAtTail();
+        return isValid() && m_index == m_links->findTail();
     }
 
     void gotoPrev()
     {
-        m_ptr.gotoPrev();
+        int size = (int)m_links->m_edges.size();
+
+        do
+        {
+            m_index++;
+        }
+        while( m_index < size &&
+               m_links->m_edges[ m_index ].m_thatObj == 0 );
     }
     void gotoNext()
     {
-        m_ptr.gotoNext();
+        int size = (int)m_links->m_edges.size();
+
+        do
+        {
+            m_index--;
+        }
+        while( m_index >= 0 &&
+               (m_index >= size ||
+                m_links->m_edges[ m_index ].m_thatObj == 0) );
     }
     void remove()
     {
-        m_ptr.remove();
+#ifdef TSTBUG
+        assert( isValid() );
+#endif
+
+        m_links->removeLink( m_index );
     }
 };
 
@@ -43,6 +43,14 @@
 
 #include "list.h"
 
+/*-------------------------------------------------------------------*
+ | A DLISTnode is its vtable pointer, its links and its list pointer,
+ | which carries the dummy bit too
+ *-------------------------------------------------------------------*/
+
+static_assert( sizeof( DLISTnode ) == 4 * sizeof( void * ),
+               "DLISTnode has grown" );
+
 /*-------------------------------------------------------------------*
  | DLISTnode::XgetHead() -- find the head of a list
  *-------------------------------------------------------------------*/
@@ -103,6 +111,7 @@ void DLISTnode::check() const
 
     DLISTnode const*node;
     int listHasHeader;
+    int length;
 
     assert( m_prev != 0 && m_next != 0 );
     //  THROW_ERR( "Bad dlist node -- NULL link" );
@@ -113,6 +122,7 @@ void DLISTnode::check() const
     }
 
     listHasHeader = 0;
+    length = 0;
     node = this;
     do
     {
@@ -120,12 +130,19 @@ void DLISTnode::check() const
                 node->m_next->m_prev == node );
         //  THROW_ERR( "Bad dlist node -- links don't match" )
 
+        assert( node->XgetList() == XgetList() );
+        //  THROW_ERR( "Dlist node belongs to another list" )
+
         if( ! node->isNode() )
         {
             assert( ! listHasHeader );
             //  THROW_ERR( "More than one header on dlist" )
             listHasHeader = 1;
         }
+        else
+        {
+            length++;
+        }
 
         node = node->m_next;
     }
@@ -133,6 +150,9 @@ void DLISTnode::check() const
 
     assert( listHasHeader );
     //  THROW_ERR( "Dlist without header" )
+
+    assert( XgetList() != 0 && XgetList()->m_length == length );
+    //  THROW_ERR( "Dlist length doesn't match its count" )
 }
 
 #endif
@@ -174,18 +194,29 @@ void DLISTbase::XappendCopy( const DLISTbase &dlist )
 /*-------------------------------------------------------------------*
  | DLISTbase::Xsplice() -- attach a list onto the end of this one
  |
- | This empties the list it is given.
+ | This empties the list it is given.  The objects that are moved
+ | have to be told which list they're on now, so it takes time in
+ | proportion to the length of the given list.
  *-------------------------------------------------------------------*/
 
 void DLISTbase::Xsplice( DLISTbase &dlist )
 {
 
 
+    DLISTnode *node;
+
     if( dlist.isEmpty() )
     {
         return;
     }
 
+    for( node = dlist.XgetHead(); node->isNode(); node = node->m_next )
+    {
+        node->XsetList( this );
+    }
+    m_length += dlist.m_length;
+    dlist.m_length = 0;
+
     if( this->isEmpty() )
     {
         DLISTnode *dlistHead = dlist.XgetHead();
@@ -216,9 +247,15 @@ void DLISTbase::Xsplice( DLISTbase &dlist )
 }
 
 /*-------------------------------------------------------------------*
- | DLISTbase::getLength() -- count the objects on the list
+ | DLISTbase::getLength() -- get the number of objects on the list,
+ |                           and check it against a walk of the list
+ |
+ | (Only if DEBUG is defined.  Otherwise, getLength() just returns
+ | the count, and is inline.)
  *-------------------------------------------------------------------*/
 
+#ifdef DEBUG
+
 int DLISTbase::getLength() const
 {
 
@@ -232,9 +269,14 @@ int DLISTbase::getLength() const
         length++;
     }
 
-    return length;
+    assert( length == m_length );
+    //  THROW_ERR( "Dlist length doesn't match its count" )
+
+    return m_length;
 }
 
+#endif
+
 /*-------------------------------------------------------------------*
  | DLISTbase::removeAll() -- remove everything from the list
  *-------------------------------------------------------------------*/
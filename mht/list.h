@@ -213,7 +213,16 @@
  *     0 otherwise.                                                  *
  *                                                                   *
  *   int getLength() const                                           *
- *     Returns the number of objects on the list.                    *
+ *     Returns the number of objects on the list.  The list keeps a  *
+ *     count of its objects up to date as they are added and         *
+ *     removed, so this doesn't walk the list.  That takes a pointer *
+ *     to the list in every node, so that a node can be unlinked on  *
+ *     its own, and an int in every list: a DLISTnode is 32 bytes    *
+ *     instead of 24 on a 64-bit machine, and a TREEnode (which has  *
+ *     a list of children) 88 instead of 64.  The pointer also       *
+ *     carries the bit that marks dummy nodes (see dummyDLISTnode),  *
+ *     which would otherwise pad the node to 32 bytes by itself.  If *
+ *     DEBUG is defined, the count is checked against a walk.        *
  *                                                                   *
  *   TYPE *getHead() const                                           *
  *     Returns a pointer to the head object.  The list must not be   *
@@ -582,6 +591,7 @@
 
 #include "except.h"
 #include <assert.h>
+#include <stdint.h>
 
 /*-------------------------------------------------------------------*
  | Declarations of stuff found in this file.
@@ -624,13 +634,39 @@ class DLISTnode
 
 private:
 
+    enum { DUMMY_BIT = 1 };
+
     DLISTnode *m_prev;
     DLISTnode *m_next;
+    uintptr_t m_list;                // list whose count includes this
+    //   node (or 0), ORed with
+    //   DUMMY_BIT in dummy nodes, so
+    //   isNode() needn't be virtual
+    //   and the bit takes no room
+
+    DLISTbase *XgetList() const
+    {
+        return (DLISTbase *)(m_list & ~(uintptr_t)DUMMY_BIT);
+    }
+    void XsetList( DLISTbase *list )
+    {
+        m_list = (uintptr_t)list | (m_list & DUMMY_BIT);
+    }
 
 protected:
 
-    DLISTnode(): m_prev( this ), m_next( this ) {}
-    DLISTnode( const DLISTnode & ): m_prev( this ), m_next( this ) {}
+    DLISTnode():
+        m_prev( this ),
+        m_next( this ),
+        m_list( 0 )
+    {
+    }
+    DLISTnode( const DLISTnode &node ):
+        m_prev( this ),
+        m_next( this ),
+        m_list( node.m_list & DUMMY_BIT )
+    {
+    }
 
     virtual ~DLISTnode()
     {
@@ -648,47 +684,22 @@ protected:
     DLISTnode *XgetHead() const;
     DLISTnode *XgetTail() const;
 
-    void Xprepend( DLISTnode *node )
-    {
-        node->checkIsNode();
-        node->checkNotOnList();
-
-        node->m_prev = m_prev;
-        node->m_next = this;
-        node->m_prev->m_next = node->m_next->m_prev = node;
-
-        check();
-    }
-
-    void Xappend( DLISTnode *node )
-    {
-        node->checkNotOnList();
-
-        node->m_prev = this;
-        node->m_next = m_next;
-        node->m_prev->m_next = node->m_next->m_prev = node;
+    inline void Xprepend( DLISTnode *node );
+    inline void Xappend( DLISTnode *node );
+    inline void unlink();
 
-        check();
-    }
+    virtual DLISTnode *XmakeCopy() const = 0;
 
-    void unlink()
+    void XmakeDummy()
     {
-        m_prev->m_next = m_next;
-        m_next->m_prev = m_prev;
-
-        m_prev->check();
-        m_next->check();
-
-        m_prev = m_next = this;
+        m_list |= DUMMY_BIT;
     }
 
-    virtual DLISTnode *XmakeCopy() const = 0;
-
 public:
 
-    virtual int isNode() const
+    int isNode() const
     {
-        return 1;
+        return ! (m_list & DUMMY_BIT);
     }
     int isOnList() const
     {
@@ -781,7 +792,9 @@ public:
  | The one in DLISTbase is used to point to the head and tail of the
  | list.  It is, in fact, a node on a circular version of the list,
  | marking the beginning and end of the list by returning 0 from
- | its isNode() member.
+ | its isNode() member.  isNode() just tests a bit that only dummy
+ | nodes set, in the low bit of the node's list pointer, so loops
+ | over lists don't make a virtual call for every node.
  |
  | The one in PTR_INTO_DLISTbase is used to hold the linkage info
  | that was in objects which have been remove()'ed.  It is also used
@@ -798,18 +811,18 @@ class dummyDLISTnode: public DLISTnode
     friend class DLISTbase;
     friend class PTR_INTO_DLISTbase;
 
-protected:
+public:
 
-    virtual DLISTnode *XmakeCopy() const
+    dummyDLISTnode(): DLISTnode()
     {
-        return new dummyDLISTnode( *this );
+        XmakeDummy();
     }
 
-public:
+protected:
 
-    virtual int isNode() const
+    virtual DLISTnode *XmakeCopy() const
     {
-        return 0;
+        return new dummyDLISTnode( *this );
     }
 };
 
@@ -847,24 +860,31 @@ public:
 
 class DLISTbase
 {
+    friend class DLISTnode;
     friend class PTR_INTO_DLISTbase;
 
 private:
 
     dummyDLISTnode m_vnode;          // see comments for
     //   dummyDLISTnode, above
+    int m_length;                    // number of nodes on the list
 
 protected:
 
-    DLISTbase(): m_vnode() {}
-    DLISTbase( const DLISTbase &dlist ): m_vnode()
+    DLISTbase(): m_vnode(), m_length( 0 )
     {
+        m_vnode.XsetList( this );
+    }
+    DLISTbase( const DLISTbase &dlist ): m_vnode(), m_length( 0 )
+    {
+        m_vnode.XsetList( this );
         XappendCopy( dlist );
     }
 
     virtual ~DLISTbase()
     {
         removeAll();
+        m_vnode.XsetList( 0 );
     }
 
 public:
@@ -900,7 +920,14 @@ public:
         return ! isEmpty() && XgetHead() == XgetTail();
     }
 
+#ifdef DEBUG
     int getLength() const;
+#else
+    int getLength() const
+    {
+        return m_length;
+    }
+#endif
 
     void removeHead()
     {
@@ -917,10 +944,12 @@ public:
     void Xreset()
     {
         m_vnode.Xreset();
+        m_length = 0;
     }
     void XcopyLinks( const DLISTbase &src )
     {
         m_vnode.XcopyLinks( src.m_vnode );
+        m_length = src.m_length;
     }
 
     void check() const
@@ -959,6 +988,66 @@ public:
 #endif
 };
 
+/*-------------------------------------------------------------------*
+ | Inline members of DLISTnode that keep the count in DLISTbase
+ |
+ | A node takes its list from the node it's put next to (the header
+ | of a list belongs to the list, too), so the count is kept no
+ | matter how the node is put on.
+ *-------------------------------------------------------------------*/
+
+inline void DLISTnode::Xprepend( DLISTnode *node )
+{
+    node->checkIsNode();
+    node->checkNotOnList();
+
+    node->m_prev = m_prev;
+    node->m_next = this;
+    node->m_prev->m_next = node->m_next->m_prev = node;
+
+    node->XsetList( XgetList() );
+    if( XgetList() != 0 )
+    {
+        XgetList()->m_length++;
+    }
+
+    check();
+}
+
+inline void DLISTnode::Xappend( DLISTnode *node )
+{
+    node->checkNotOnList();
+
+    node->m_prev = this;
+    node->m_next = m_next;
+    node->m_prev->m_next = node->m_next->m_prev = node;
+
+    node->XsetList( XgetList() );
+    if( XgetList() != 0 )
+    {
+        XgetList()->m_length++;
+    }
+
+    check();
+}
+
+inline void DLISTnode::unlink()
+{
+    m_prev->m_next = m_next;
+    m_next->m_prev = m_prev;
+
+    if( XgetList() != 0 )
+    {
+        XgetList()->m_length--;
+        XsetList( 0 );
+    }
+
+    m_prev->check();
+    m_next->check();
+
+    m_prev = m_next = this;
+}
+
 /*-------------------------------------------------------------------*
  | MEMBERS_FOR_DLISTbase() -- macro that declares those members of
  |                            a DLIST which can't be inherited
@@ -984,6 +1073,10 @@ public:
  
 /*-------------------------------------------------------------------*
  | PTR_INTO_DLISTbase -- base class for all PTR_INTO_xDLIST's
+ |
+ | PTR_INTO's aren't deleted through pointers to this class, so its
+ | destructor isn't virtual, and a PTR_INTO is no more than a
+ | pointer and a dummy node.
  *-------------------------------------------------------------------*/
 
 class PTR_INTO_DLISTbase
@@ -1029,7 +1122,7 @@ protected:
         ptr.checkNotRemoved();
     }
 
-    virtual ~PTR_INTO_DLISTbase()
+    ~PTR_INTO_DLISTbase()
     {
         m_dummy.Xreset();
     }
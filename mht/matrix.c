@@ -48,11 +48,9 @@
 #include "vector.h"
 #include "matrix.h"
 
-/*-------------------------------------------------------------------*
- | Constants
- *-------------------------------------------------------------------*/
-
-static const double TINY = 1e-20;
+/* NOTE: the scratch buffers used by inv(), det(), and luDecompose()
+   are thread_local, so that MATRIX arithmetic can be done by the
+   worker threads of MDL_MHT::measureAndValidate() (see mdlmht.H) */
 
 /*-------------------------------------------------------------------*
  | Static routines
@@ -220,9 +218,9 @@ tmpMATRIX MATRIX::inv()
 {
 
 
-    static VECTOR_OF< int > originalRow;
+    static thread_local VECTOR_OF< int > originalRow;
     originalRow.resize( m_numRows );
-    static VECTOR_OF< double > colBuf;
+    static thread_local VECTOR_OF< double > colBuf;
     colBuf.resize( m_numRows );
     MATRIX lu( *this );
     tmpMATRIX tmp( m_numRows, m_numCols );
@@ -271,7 +269,7 @@ double MATRIX::det()
 #endif
 
     MATRIX lu( *this );
-    static VECTOR_OF< int > dummyBuf;
+    static thread_local VECTOR_OF< int > dummyBuf;
     dummyBuf.resize( m_numRows );
     double d;
     int numSwapsWasOdd;
@@ -299,17 +297,30 @@ void MATRIX::print( int numSpaces ) const
 {
 
 
+    PrintMatrixData( m_data, m_numRows, m_numCols, numSpaces );
+}
+
+/*-------------------------------------------------------------------*
+ | PrintMatrixData() -- print out the entries of a matrix, for
+ |                      MATRIX::print() and FIXED_MATRIX::print()
+ *-------------------------------------------------------------------*/
+
+void PrintMatrixData( const double *data, int numRows, int numCols,
+                      int numSpaces )
+{
+
+
     int row, col;
-    double *p = m_data;
+    const double *p = data;
 
 #define ROUND( v ) (((v) >= 0) ? (int)((v) + .5) : -(int)(-(v) + .5))
 #define DBL( v ) ((double)ROUND( (v) * 10000 ) / 10000)
 
-    for( row = 0; row < m_numRows; row++ )
+    for( row = 0; row < numRows; row++ )
     {
         Indent( numSpaces );
 
-        for( col = 0; col < m_numCols; col++ )
+        for( col = 0; col < numCols; col++ )
         {
             std::cout << DBL( *p ) << " ";
             p++;
@@ -660,12 +671,12 @@ static int luDecompose( MATRIX &mat, int *originalRow )
     const int numRows = mat.getNumRows();
 #define numCols numRows
     double sum;
-    static VECTOR_OF< double > scaler;
+    static thread_local VECTOR_OF< double > scaler;
     scaler.resize( numRows );
     double biggest;
     int biggestRow;
     double tmpDbl;
-    static VECTOR_OF< double > tmpDblArray;
+    static thread_local VECTOR_OF< double > tmpDblArray;
     tmpDblArray.resize( numCols );
     int i;
 
@@ -749,7 +760,7 @@ static int luDecompose( MATRIX &mat, int *originalRow )
         p0 = &mat( col, col );
         if( *p0 == 0 )
         {
-            *p0 = TINY;
+            *p0 = MATRIX_TINY;
         }
 
         if( col != numCols - 1 )
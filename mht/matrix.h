@@ -111,6 +111,104 @@
  *                                                                   *
  *       The indentation defaults to 0.                              *
  *                                                                   *
+ *   A FIXED_MATRIX< numRows, numCols > is a matrix whose size is    *
+ *   fixed when the program is compiled.  Its entries are kept in    *
+ *   the object itself, so making, copying and returning one never   *
+ *   allocates memory, and every loop over its entries has a         *
+ *   constant count that the compiler can unroll.  It's meant for    *
+ *   the small matrices of a Kalman filter step, where MATRIX spends *
+ *   most of its time in new and delete.  It has the same operators  *
+ *   and member functions as MATRIX, except reduce(), and each one   *
+ *   gives exactly the same result as the MATRIX version.  Sizes     *
+ *   that don't match (in a product, for instance) are caught by the *
+ *   compiler.  A FIXED_MATRIX can also be made from a MATRIX of the *
+ *   same size:                                                      *
+ *                                                                   *
+ *     FIXED_MATRIX< numRows, numCols > mat( m0 )                    *
+ *                                                                   *
+ *   The entries of FIXED_MATRIX's, and of the FIXED_SYMMETRIC's and *
+ *   FIXED_CHOLESKY's below, are MHT_REAL's (see precision.H).       *
+ *   They're doubles unless MHT_SINGLE_PRECISION is defined, in      *
+ *   which case they're floats, and the arithmetic is done in single *
+ *   precision, so the results only approximate those of MATRIX.     *
+ *                                                                   *
+ *   Arithmetic on FIXED_MATRIX's is lazy: +, -, * and trans()       *
+ *   return small expression objects instead of matrices, and        *
+ *   nothing is computed until an expression is used to make or      *
+ *   assign a FIXED_MATRIX (or one of its entries is asked for).  So *
+ *                                                                   *
+ *     FIXED_MATRIX< 4, 4 > P1 = F * P * F.trans() + Q               *
+ *                                                                   *
+ *   fills in each entry of P1 in a single pass, with the transpose  *
+ *   and the sum folded into it.  The only matrix worked out along   *
+ *   the way is F * P, because a product uses each entry of its      *
+ *   factors several times, and so evaluates any factor that isn't a *
+ *   plain matrix (or its transpose) once, on the stack.  Assigning  *
+ *   an expression evaluates it into a temporary before copying, so  *
+ *   the matrix being assigned to can appear in it.                  *
+ *                                                                   *
+ *   A FIXED_SYMMETRIC< n > is a symmetric n x n matrix that keeps   *
+ *   only its lower triangle, n (n + 1) / 2 entries instead of n n   *
+ *   (10 instead of 16 for a 4 x 4 covariance).  It can be used in   *
+ *   expressions like a FIXED_MATRIX, and made or assigned from an   *
+ *   expression, which is then evaluated on and below the diagonal   *
+ *   only, so                                                        *
+ *                                                                   *
+ *     FIXED_SYMMETRIC< 4 > P1 = F * P * F.trans() + Q               *
+ *                                                                   *
+ *   works out 10 entries of the final product instead of 16.  It's  *
+ *   up to the caller to make sure the expression really is          *
+ *   symmetric.  ( r, c ) and ( c, r ) are the same entry, so        *
+ *   setting one sets the other.  Besides operator=, operator(),     *
+ *   getNumRows(), getNumCols() and print(), it has                  *
+ *                                                                   *
+ *     subtractGram( g )                                             *
+ *       Subtract g' g, for a k x n FIXED_MATRIX g.  This is the     *
+ *       symmetric form of a Kalman covariance update (see           *
+ *       FIXED_CHOLESKY::forwardSolve() below).                      *
+ *                                                                   *
+ *     getData()                                                     *
+ *       Return a pointer to the entry at row 0, column 0.  The rest *
+ *       of the lower triangle follows it, row by row.  Entry        *
+ *       ( r, c ) is at FIXED_SYMMETRIC< n >::index( r, c ).         *
+ *                                                                   *
+ *   A FIXED_CHOLESKY< n > is the Cholesky factorization L L' of a   *
+ *   symmetric, positive definite n x n matrix, made with            *
+ *                                                                   *
+ *     FIXED_CHOLESKY< n > chol( m0 )                                *
+ *                                                                   *
+ *   where m0 is a FIXED_MATRIX, a FIXED_SYMMETRIC or an expression  *
+ *   (only the lower triangle of m0 is looked at; without m0, the    *
+ *   factor is garbage until another FIXED_CHOLESKY is assigned to   *
+ *   it).  It replaces separate calls to det() and inv(), each of    *
+ *   which does its own LU decomposition, with one factorization     *
+ *   that's cheaper than either:                                     *
+ *                                                                   *
+ *     logDet()                                                      *
+ *       Return the log of the determinant of m0.                    *
+ *                                                                   *
+ *     forwardSolve( b )                                             *
+ *     backSolve( y )                                                *
+ *       Return L.inv() * b and L.trans().inv() * y, for n x c       *
+ *       FIXED_MATRIX's b and y.  If g = forwardSolve( b ), then     *
+ *       b' m0.inv() b = g' g.                                       *
+ *                                                                   *
+ *     solve( b )                                                    *
+ *       Return m0.inv() * b, which is                               *
+ *       backSolve( forwardSolve( b ) ).                             *
+ *                                                                   *
+ *     mahalanobis( v )                                              *
+ *       Return v' m0.inv() v, for an n x 1 FIXED_MATRIX v, as the   *
+ *       squared length of L.inv() v (one forward solve).  Unlike    *
+ *       the product, this can't come out negative.                  *
+ *                                                                   *
+ *     print( numSpaces )                                            *
+ *       Print out L.                                                *
+ *                                                                   *
+ *   FIXED_CHOLESKY< 2 > is written out in closed form, and keeps    *
+ *   just the three entries of L, which getData() returns in the     *
+ *   order L( 0, 0 ), L( 1, 0 ), L( 1, 1 ).                          *
+ *                                                                   *
  * IMPLEMENTATION NOTES:                                             *
  *                                                                   *
  *   The implementation of matrices in matrix.H and matrix.C is a    *
@@ -191,8 +289,10 @@
 
 #include <stdarg.h>
 #include <string.h>
+#include <math.h>
 
 #include "except.h"
+#include "precision.h"
 #include <assert.h>
 
 /*-------------------------------------------------------------------*
@@ -201,6 +301,19 @@
 
 class MATRIX;
 class tmpMATRIX;
+template< int NUM_ROWS, int NUM_COLS > class FIXED_MATRIX;
+template< class EXPR > class FIXED_TRANS;
+template< int N > class FIXED_SYMMETRIC;
+
+/*-------------------------------------------------------------------*
+ | Constants and routines shared by MATRIX and FIXED_MATRIX
+ *-------------------------------------------------------------------*/
+
+static const double MATRIX_TINY = 1e-20;  // stands in for a zero pivot
+                                          //   in an LU decomposition
+
+void PrintMatrixData( const double *data, int numRows, int numCols,
+                      int numSpaces );
 
 /*-------------------------------------------------------------------*
  | MATRIX -- basic matrix class
@@ -496,5 +609,1038 @@ inline tmpMATRIX operator*( const MATRIX &m,
     return tmp;
 }
 
+/*-------------------------------------------------------------------*
+ | FIXED_EXPR -- base of FIXED_MATRIX and of the expressions made out
+ |               of FIXED_MATRIX's
+ |
+ | EXPR is the class derived from this one.  It has enums ROWS and
+ | COLS giving its size, and an operator()( row, col ) that works out
+ | one entry.
+ *-------------------------------------------------------------------*/
+
+template< class EXPR >
+class FIXED_EXPR
+{
+public:
+
+    const EXPR &expr() const
+    {
+        return *(const EXPR *)this;
+    }
+
+    inline FIXED_TRANS< EXPR > trans() const;
+};
+
+/*-------------------------------------------------------------------*
+ | FIXED_OPERAND -- how an expression holds on to an operand
+ | FIXED_FACTOR -- how a product holds on to a factor
+ |
+ | Matrices are held by reference, and other expressions by value
+ | (they're small, and may be temporaries).  A product uses each entry
+ | of its factors several times, so a factor that takes any arithmetic
+ | to work out is evaluated once, into a FIXED_MATRIX, when the
+ | product is made.
+ *-------------------------------------------------------------------*/
+
+template< class EXPR >
+struct FIXED_OPERAND
+{
+    typedef const EXPR TYPE;
+};
+
+template< int NUM_ROWS, int NUM_COLS >
+struct FIXED_OPERAND< FIXED_MATRIX< NUM_ROWS, NUM_COLS > >
+{
+    typedef const FIXED_MATRIX< NUM_ROWS, NUM_COLS > &TYPE;
+};
+
+template< class EXPR >
+struct FIXED_FACTOR
+{
+    typedef const FIXED_MATRIX< EXPR::ROWS, EXPR::COLS > TYPE;
+};
+
+template< int NUM_ROWS, int NUM_COLS >
+struct FIXED_FACTOR< FIXED_MATRIX< NUM_ROWS, NUM_COLS > >
+{
+    typedef const FIXED_MATRIX< NUM_ROWS, NUM_COLS > &TYPE;
+};
+
+template< int NUM_ROWS, int NUM_COLS >
+struct FIXED_FACTOR< FIXED_TRANS< FIXED_MATRIX< NUM_ROWS, NUM_COLS > > >
+{
+    typedef const FIXED_TRANS< FIXED_MATRIX< NUM_ROWS, NUM_COLS > > TYPE;
+};
+
+template< int N >
+struct FIXED_OPERAND< FIXED_SYMMETRIC< N > >
+{
+    typedef const FIXED_SYMMETRIC< N > &TYPE;
+};
+
+template< int N >
+struct FIXED_FACTOR< FIXED_SYMMETRIC< N > >
+{
+    typedef const FIXED_SYMMETRIC< N > &TYPE;
+};
+
+/*-------------------------------------------------------------------*
+ | FIXED_MATRIX -- matrix with its size fixed at compile time
+ *-------------------------------------------------------------------*/
+
+template< int NUM_ROWS, int NUM_COLS >
+class FIXED_MATRIX: public FIXED_EXPR< FIXED_MATRIX< NUM_ROWS, NUM_COLS > >
+{
+public:
+
+    enum { ROWS = NUM_ROWS, COLS = NUM_COLS, SIZE = NUM_ROWS * NUM_COLS };
+
+private:
+
+    MHT_REAL m_data[ SIZE ];
+
+public:
+
+    FIXED_MATRIX()
+    {
+    }
+
+    FIXED_MATRIX( const MATRIX &src )
+    {
+#ifdef TSTBUG
+        assert( src.getNumRows() == NUM_ROWS &&
+                src.getNumCols() == NUM_COLS );
+#endif
+
+        const double *srcData = src.getData();
+        int i;
+
+        for( i = 0; i < SIZE; i++ )
+        {
+            m_data[ i ] = srcData[ i ];
+        }
+    }
+
+    /* evaluate an expression straight into the new matrix */
+    template< class EXPR >
+    FIXED_MATRIX( const FIXED_EXPR< EXPR > &src )
+    {
+        static_assert( EXPR::ROWS == NUM_ROWS && EXPR::COLS == NUM_COLS,
+                       "matrix sizes don't match" );
+
+        const EXPR &expr = src.expr();
+        int row, col;
+
+        for( row = 0; row < NUM_ROWS; row++ )
+            for( col = 0; col < NUM_COLS; col++ )
+            {
+                m_data[ row * NUM_COLS + col ] = expr( row, col );
+            }
+    }
+
+    /* the expression may use this matrix (as in m = m * m0), so it's
+       evaluated into a temporary first */
+    template< class EXPR >
+    FIXED_MATRIX &operator=( const FIXED_EXPR< EXPR > &src )
+    {
+        FIXED_MATRIX tmp( src );
+
+        memcpy( m_data, tmp.m_data, sizeof( m_data ) );
+        return *this;
+    }
+
+    FIXED_MATRIX &operator=( MHT_REAL val )
+    {
+        int i;
+
+        for( i = 0; i < SIZE; i++ )
+        {
+            m_data[ i ] = val;
+        }
+
+        return *this;
+    }
+
+    MHT_REAL &operator()( int row = 0, int col = 0 )
+    {
+#ifdef TSTBUG
+        assert( 0 <= row && row < NUM_ROWS &&
+                0 <= col && col < NUM_COLS );
+#endif
+
+        return m_data[ row * NUM_COLS + col ];
+    }
+
+    const MHT_REAL &operator()( int row = 0, int col = 0 ) const
+    {
+#ifdef TSTBUG
+        assert( 0 <= row && row < NUM_ROWS &&
+                0 <= col && col < NUM_COLS );
 #endif
 
+        return m_data[ row * NUM_COLS + col ];
+    }
+
+    void vset( double firstVal, va_list ap )
+    {
+        int i;
+
+        m_data[ 0 ] = firstVal;
+        for( i = 1; i < SIZE; i++ )
+        {
+            m_data[ i ] = va_arg( ap, double );
+        }
+    }
+
+    void set( double firstVal, ... )
+    {
+        va_list ap;
+
+        va_start( ap, firstVal );
+        vset( firstVal, ap );
+        va_end( ap );
+    }
+
+    int isIdentity() const
+    {
+        int row, col;
+
+        if( NUM_ROWS != NUM_COLS )
+        {
+            return 0;
+        }
+
+        for( row = 0; row < NUM_ROWS; row++ )
+            for( col = 0; col < NUM_COLS; col++ )
+                if( m_data[ row * NUM_COLS + col ] != (row == col) )
+                {
+                    return 0;
+                }
+
+        return 1;
+    }
+
+    int getNumRows() const
+    {
+        return NUM_ROWS;
+    }
+    int getNumCols() const
+    {
+        return NUM_COLS;
+    }
+    MHT_REAL *getData()
+    {
+        return m_data;
+    }
+    const MHT_REAL *getData() const
+    {
+        return m_data;
+    }
+
+    FIXED_MATRIX inv() const;
+    MHT_REAL det() const;
+
+    void print( int numSpaces = 0 ) const
+    {
+        double data[ SIZE ];
+        int i;
+
+        for( i = 0; i < SIZE; i++ )
+        {
+            data[ i ] = m_data[ i ];
+        }
+
+        PrintMatrixData( data, NUM_ROWS, NUM_COLS, numSpaces );
+    }
+
+private:
+
+    static int luDecompose( MHT_REAL *lu, int *originalRow );
+    static void luSolve( const MHT_REAL *lu, const int *originalRow,
+                         MHT_REAL *colBuf );
+};
+
+/*-------------------------------------------------------------------*
+ | Expressions on FIXED_MATRIX's
+ |
+ | Each entry is worked out with the same operations, in the same
+ | order, as in the MATRIX versions, so the results are identical.
+ *-------------------------------------------------------------------*/
+
+template< class EXPR >
+class FIXED_TRANS: public FIXED_EXPR< FIXED_TRANS< EXPR > >
+{
+private:
+
+    typename FIXED_OPERAND< EXPR >::TYPE m_expr;
+
+public:
+
+    enum { ROWS = EXPR::COLS, COLS = EXPR::ROWS };
+
+    FIXED_TRANS( const EXPR &expr ):
+        m_expr( expr )
+    {
+    }
+
+    MHT_REAL operator()( int row = 0, int col = 0 ) const
+    {
+        return m_expr( col, row );
+    }
+};
+
+template< class LEFT, class RIGHT >
+class FIXED_SUM: public FIXED_EXPR< FIXED_SUM< LEFT, RIGHT > >
+{
+private:
+
+    typename FIXED_OPERAND< LEFT >::TYPE m_left;
+    typename FIXED_OPERAND< RIGHT >::TYPE m_right;
+
+public:
+
+    enum { ROWS = LEFT::ROWS, COLS = LEFT::COLS };
+
+    FIXED_SUM( const LEFT &left, const RIGHT &right ):
+        m_left( left ),
+        m_right( right )
+    {
+        static_assert( (int)LEFT::ROWS == (int)RIGHT::ROWS &&
+                       (int)LEFT::COLS == (int)RIGHT::COLS,
+                       "matrix sizes don't match" );
+    }
+
+    MHT_REAL operator()( int row = 0, int col = 0 ) const
+    {
+        return m_left( row, col ) + m_right( row, col );
+    }
+};
+
+template< class LEFT, class RIGHT >
+class FIXED_DIFFERENCE: public FIXED_EXPR< FIXED_DIFFERENCE< LEFT, RIGHT > >
+{
+private:
+
+    typename FIXED_OPERAND< LEFT >::TYPE m_left;
+    typename FIXED_OPERAND< RIGHT >::TYPE m_right;
+
+public:
+
+    enum { ROWS = LEFT::ROWS, COLS = LEFT::COLS };
+
+    FIXED_DIFFERENCE( const LEFT &left, const RIGHT &right ):
+        m_left( left ),
+        m_right( right )
+    {
+        static_assert( (int)LEFT::ROWS == (int)RIGHT::ROWS &&
+                       (int)LEFT::COLS == (int)RIGHT::COLS,
+                       "matrix sizes don't match" );
+    }
+
+    MHT_REAL operator()( int row = 0, int col = 0 ) const
+    {
+        return m_left( row, col ) - m_right( row, col );
+    }
+};
+
+template< class EXPR >
+class FIXED_SCALE: public FIXED_EXPR< FIXED_SCALE< EXPR > >
+{
+private:
+
+    typename FIXED_OPERAND< EXPR >::TYPE m_expr;
+    MHT_REAL m_num;
+
+public:
+
+    enum { ROWS = EXPR::ROWS, COLS = EXPR::COLS };
+
+    FIXED_SCALE( const EXPR &expr, MHT_REAL num ):
+        m_expr( expr ),
+        m_num( num )
+    {
+    }
+
+    MHT_REAL operator()( int row = 0, int col = 0 ) const
+    {
+        return m_expr( row, col ) * m_num;
+    }
+};
+
+template< class LEFT, class RIGHT >
+class FIXED_PRODUCT: public FIXED_EXPR< FIXED_PRODUCT< LEFT, RIGHT > >
+{
+private:
+
+    typename FIXED_FACTOR< LEFT >::TYPE m_left;
+    typename FIXED_FACTOR< RIGHT >::TYPE m_right;
+
+public:
+
+    enum { ROWS = LEFT::ROWS, COLS = RIGHT::COLS };
+
+    FIXED_PRODUCT( const LEFT &left, const RIGHT &right ):
+        m_left( left ),
+        m_right( right )
+    {
+        static_assert( (int)LEFT::COLS == (int)RIGHT::ROWS,
+                       "matrix sizes don't match" );
+    }
+
+    MHT_REAL operator()( int row = 0, int col = 0 ) const
+    {
+        MHT_REAL sum = 0.;
+        int i;
+
+        for( i = 0; i < LEFT::COLS; i++ )
+        {
+            sum += m_left( row, i ) * m_right( i, col );
+        }
+
+        return sum;
+    }
+};
+
+template< class EXPR >
+inline FIXED_TRANS< EXPR > FIXED_EXPR< EXPR >::trans() const
+{
+    return FIXED_TRANS< EXPR >( expr() );
+}
+
+template< class LEFT, class RIGHT >
+inline FIXED_SUM< LEFT, RIGHT >
+operator+( const FIXED_EXPR< LEFT > &left,
+           const FIXED_EXPR< RIGHT > &right )
+{
+    return FIXED_SUM< LEFT, RIGHT >( left.expr(), right.expr() );
+}
+
+template< class LEFT, class RIGHT >
+inline FIXED_DIFFERENCE< LEFT, RIGHT >
+operator-( const FIXED_EXPR< LEFT > &left,
+           const FIXED_EXPR< RIGHT > &right )
+{
+    return FIXED_DIFFERENCE< LEFT, RIGHT >( left.expr(), right.expr() );
+}
+
+template< class EXPR >
+inline FIXED_SCALE< EXPR >
+operator*( const FIXED_EXPR< EXPR > &expr,
+           MHT_REAL num )
+{
+    return FIXED_SCALE< EXPR >( expr.expr(), num );
+}
+
+template< class LEFT, class RIGHT >
+inline FIXED_PRODUCT< LEFT, RIGHT >
+operator*( const FIXED_EXPR< LEFT > &left,
+           const FIXED_EXPR< RIGHT > &right )
+{
+    return FIXED_PRODUCT< LEFT, RIGHT >( left.expr(), right.expr() );
+}
+
+/*-------------------------------------------------------------------*
+ | FIXED_MATRIX::inv() -- invert a matrix
+ | FIXED_MATRIX::det() -- compute the determinant of a matrix
+ |
+ | These follow MATRIX::inv() and MATRIX::det() step for step (see
+ | matrix.C), with the scratch space on the stack.
+ *-------------------------------------------------------------------*/
+
+template< int NUM_ROWS, int NUM_COLS >
+FIXED_MATRIX< NUM_ROWS, NUM_COLS >
+FIXED_MATRIX< NUM_ROWS, NUM_COLS >::inv() const
+{
+    FIXED_MATRIX lu( *this );
+    FIXED_MATRIX tmp;
+    int originalRow[ NUM_ROWS ];
+    MHT_REAL colBuf[ NUM_ROWS ];
+    int row, col;
+
+    luDecompose( lu.m_data, originalRow );
+
+    for( col = 0; col < NUM_COLS; col++ )
+    {
+        for( row = 0; row < NUM_ROWS; row++ )
+        {
+            colBuf[ row ] = 0;
+        }
+        colBuf[ col ] = 1;
+
+        luSolve( lu.m_data, originalRow, colBuf );
+
+        for( row = 0; row < NUM_ROWS; row++ )
+        {
+            tmp( row, col ) = colBuf[ row ];
+        }
+    }
+
+    return tmp;
+}
+
+template< int NUM_ROWS, int NUM_COLS >
+MHT_REAL FIXED_MATRIX< NUM_ROWS, NUM_COLS >::det() const
+{
+    FIXED_MATRIX lu( *this );
+    int dummyBuf[ NUM_ROWS ];
+    MHT_REAL d;
+    int i;
+
+    d = luDecompose( lu.m_data, dummyBuf ) ? -lu( 0, 0 ) : lu( 0, 0 );
+    for( i = 1; i < NUM_ROWS; i++ )
+    {
+        d *= lu( i, i );
+    }
+
+    return d;
+}
+
+/*-------------------------------------------------------------------*
+ | FIXED_MATRIX::luDecompose() -- compute the LU Decomposition of a
+ |                                square matrix, in place
+ |
+ | See luDecompose() in matrix.C for what this does.
+ *-------------------------------------------------------------------*/
+
+template< int NUM_ROWS, int NUM_COLS >
+int FIXED_MATRIX< NUM_ROWS, NUM_COLS >::luDecompose( MHT_REAL *lu,
+                                                     int *originalRow )
+{
+    const int n = NUM_ROWS;
+    int numSwapsIsOdd = 0;
+    MHT_REAL scaler[ NUM_ROWS ];
+    MHT_REAL biggest;
+    int biggestRow;
+    MHT_REAL sum;
+    MHT_REAL tmpDbl;
+    int row, col, i;
+
+#ifdef TSTBUG
+    assert( NUM_ROWS == NUM_COLS );
+#endif
+
+    for( row = 0; row < n; row++ )
+    {
+        biggest = fabs( lu[ row * n ] );
+        for( col = 1; col < n; col++ )
+            if( (tmpDbl = fabs( lu[ row * n + col ] )) > biggest )
+            {
+                biggest = tmpDbl;
+            }
+
+#ifdef TSTBUG
+        assert( biggest != 0 );
+#endif
+
+        scaler[ row ] = 1. / biggest;
+    }
+
+    for( col = 0; col < n; col++ )
+    {
+        for( row = 0; row < col; row++ )
+        {
+            sum = lu[ row * n + col ];
+            for( i = 0; i < row; i++ )
+            {
+                sum -= lu[ row * n + i ] * lu[ i * n + col ];
+            }
+            lu[ row * n + col ] = sum;
+        }
+
+        biggest = 0;
+        biggestRow = col;
+        for( row = col; row < n; row++ )
+        {
+            sum = lu[ row * n + col ];
+            for( i = 0; i < col; i++ )
+            {
+                sum -= lu[ row * n + i ] * lu[ i * n + col ];
+            }
+            lu[ row * n + col ] = sum;
+
+            if( (tmpDbl = scaler[ row ] * fabs( sum )) >= biggest )
+            {
+                biggest = tmpDbl;
+                biggestRow = row;
+            }
+        }
+
+        if( col != biggestRow )
+        {
+            for( i = 0; i < n; i++ )
+            {
+                tmpDbl = lu[ biggestRow * n + i ];
+                lu[ biggestRow * n + i ] = lu[ col * n + i ];
+                lu[ col * n + i ] = tmpDbl;
+            }
+
+            scaler[ biggestRow ] = scaler[ col ];
+
+            numSwapsIsOdd ^= 1;
+        }
+
+        originalRow[ col ] = biggestRow;
+
+        if( lu[ col * n + col ] == 0 )
+        {
+            lu[ col * n + col ] = MATRIX_TINY;
+        }
+
+        if( col != n - 1 )
+        {
+            tmpDbl = 1. / lu[ col * n + col ];
+            for( row = col + 1; row < n; row++ )
+            {
+                lu[ row * n + col ] *= tmpDbl;
+            }
+        }
+    }
+
+    return numSwapsIsOdd;
+}
+
+/*-------------------------------------------------------------------*
+ | FIXED_MATRIX::luSolve() -- solve the set of simultaneous equations
+ |                            described in an LU Decomposition
+ |
+ | See luSolve() in matrix.C for what this does.
+ *-------------------------------------------------------------------*/
+
+template< int NUM_ROWS, int NUM_COLS >
+void FIXED_MATRIX< NUM_ROWS, NUM_COLS >::luSolve( const MHT_REAL *lu,
+                                                  const int *originalRow,
+                                                  MHT_REAL *colBuf )
+{
+    const int n = NUM_ROWS;
+    int firstNonZeroRow;
+    MHT_REAL sum;
+    int row, i;
+
+    /* forward substitution, starting from the first row where the
+       solution is not zero */
+    firstNonZeroRow = n;
+    for( row = 0; row < n; row++ )
+    {
+        i = originalRow[ row ];
+        sum = colBuf[ i ];
+        colBuf[ i ] = colBuf[ row ];
+
+        if( firstNonZeroRow < n )
+        {
+            for( i = firstNonZeroRow; i < row; i++ )
+            {
+                sum -= lu[ row * n + i ] * colBuf[ i ];
+            }
+        }
+        else if( sum != 0 )
+        {
+            firstNonZeroRow = row;
+        }
+
+        colBuf[ row ] = sum;
+    }
+
+    /* backward substitution */
+    for( row = n - 1; row >= 0; row-- )
+    {
+        sum = colBuf[ row ];
+        for( i = row + 1; i < n; i++ )
+        {
+            sum -= lu[ row * n + i ] * colBuf[ i ];
+        }
+        colBuf[ row ] = sum / lu[ row * n + row ];
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | FIXED_SYMMETRIC -- symmetric matrix with its size fixed at compile
+ |                    time, of which only the lower triangle is kept
+ *-------------------------------------------------------------------*/
+
+template< int N >
+class FIXED_SYMMETRIC: public FIXED_EXPR< FIXED_SYMMETRIC< N > >
+{
+public:
+
+    enum { ROWS = N, COLS = N, SIZE = N * (N + 1) / 2 };
+
+private:
+
+    MHT_REAL m_data[ SIZE ];         // lower triangle, row by row
+
+public:
+
+    /* where entry ( row, col ) is in getData() */
+    static int index( int row, int col )
+    {
+        return row >= col ? row * (row + 1) / 2 + col
+                          : col * (col + 1) / 2 + row;
+    }
+
+    FIXED_SYMMETRIC()
+    {
+    }
+
+    /* evaluate just the lower triangle of an expression (which had
+       better be symmetric) */
+    template< class EXPR >
+    FIXED_SYMMETRIC( const FIXED_EXPR< EXPR > &src )
+    {
+        static_assert( (int)EXPR::ROWS == N && (int)EXPR::COLS == N,
+                       "matrix sizes don't match" );
+
+        const EXPR &expr = src.expr();
+        int row, col;
+
+        for( row = 0; row < N; row++ )
+            for( col = 0; col <= row; col++ )
+            {
+                m_data[ index( row, col ) ] = expr( row, col );
+            }
+    }
+
+    template< class EXPR >
+    FIXED_SYMMETRIC &operator=( const FIXED_EXPR< EXPR > &src )
+    {
+        FIXED_SYMMETRIC tmp( src );
+
+        memcpy( m_data, tmp.m_data, sizeof( m_data ) );
+        return *this;
+    }
+
+    FIXED_SYMMETRIC &operator=( MHT_REAL val )
+    {
+        int i;
+
+        for( i = 0; i < SIZE; i++ )
+        {
+            m_data[ i ] = val;
+        }
+
+        return *this;
+    }
+
+    /* NOTE: ( r, c ) and ( c, r ) are the same entry */
+    MHT_REAL &operator()( int row = 0, int col = 0 )
+    {
+#ifdef TSTBUG
+        assert( 0 <= row && row < N &&
+                0 <= col && col < N );
+#endif
+
+        return m_data[ index( row, col ) ];
+    }
+
+    const MHT_REAL &operator()( int row = 0, int col = 0 ) const
+    {
+#ifdef TSTBUG
+        assert( 0 <= row && row < N &&
+                0 <= col && col < N );
+#endif
+
+        return m_data[ index( row, col ) ];
+    }
+
+    /* subtract g' g, for a k x N matrix g */
+    template< int K >
+    void subtractGram( const FIXED_MATRIX< K, N > &g )
+    {
+        MHT_REAL sum;
+        int row, col, i;
+
+        for( row = 0; row < N; row++ )
+            for( col = 0; col <= row; col++ )
+            {
+                sum = 0.;
+                for( i = 0; i < K; i++ )
+                {
+                    sum += g( i, row ) * g( i, col );
+                }
+                m_data[ index( row, col ) ] -= sum;
+            }
+    }
+
+    int getNumRows() const
+    {
+        return N;
+    }
+    int getNumCols() const
+    {
+        return N;
+    }
+    MHT_REAL *getData()
+    {
+        return m_data;
+    }
+    const MHT_REAL *getData() const
+    {
+        return m_data;
+    }
+
+    void print( int numSpaces = 0 ) const
+    {
+        FIXED_MATRIX< N, N > full( *this );
+
+        full.print( numSpaces );
+    }
+};
+
+/*-------------------------------------------------------------------*
+ | FIXED_CHOLESKY -- Cholesky factorization of a FIXED_MATRIX
+ *-------------------------------------------------------------------*/
+
+template< int N >
+class FIXED_CHOLESKY
+{
+private:
+
+    FIXED_MATRIX< N, N > m_L;        // factor, in the lower triangle
+                                     //   (the rest is zero)
+
+public:
+
+    FIXED_CHOLESKY()
+    {
+    }
+
+    template< class EXPR >
+    FIXED_CHOLESKY( const FIXED_EXPR< EXPR > &src )
+    {
+        static_assert( (int)EXPR::ROWS == N && (int)EXPR::COLS == N,
+                       "matrix sizes don't match" );
+
+        const EXPR &m0 = src.expr();
+        MHT_REAL sum;
+        int row, col, i;
+
+        m_L = 0.;
+        for( col = 0; col < N; col++ )
+        {
+            sum = m0( col, col );
+            for( i = 0; i < col; i++ )
+            {
+                sum -= m_L( col, i ) * m_L( col, i );
+            }
+
+#ifdef TSTBUG
+            assert( sum > 0 );
+#endif
+
+            m_L( col, col ) = sqrt( sum );
+
+            for( row = col + 1; row < N; row++ )
+            {
+                sum = m0( row, col );
+                for( i = 0; i < col; i++ )
+                {
+                    sum -= m_L( row, i ) * m_L( col, i );
+                }
+                m_L( row, col ) = sum / m_L( col, col );
+            }
+        }
+    }
+
+    MHT_REAL logDet() const
+    {
+        MHT_REAL prod = 1.;
+        int i;
+
+        for( i = 0; i < N; i++ )
+        {
+            prod *= m_L( i, i );
+        }
+
+        return 2. * log( prod );
+    }
+
+    template< int NUM_COLS >
+    FIXED_MATRIX< N, NUM_COLS > forwardSolve(
+        const FIXED_MATRIX< N, NUM_COLS > &b ) const
+    {
+        FIXED_MATRIX< N, NUM_COLS > y;
+        MHT_REAL sum;
+        int row, col, i;
+
+        for( col = 0; col < NUM_COLS; col++ )
+            for( row = 0; row < N; row++ )
+            {
+                sum = b( row, col );
+                for( i = 0; i < row; i++ )
+                {
+                    sum -= m_L( row, i ) * y( i, col );
+                }
+                y( row, col ) = sum / m_L( row, row );
+            }
+
+        return y;
+    }
+
+    template< int NUM_COLS >
+    FIXED_MATRIX< N, NUM_COLS > backSolve(
+        const FIXED_MATRIX< N, NUM_COLS > &y ) const
+    {
+        FIXED_MATRIX< N, NUM_COLS > x;
+        MHT_REAL sum;
+        int row, col, i;
+
+        for( col = 0; col < NUM_COLS; col++ )
+            for( row = N - 1; row >= 0; row-- )
+            {
+                sum = y( row, col );
+                for( i = row + 1; i < N; i++ )
+                {
+                    sum -= m_L( i, row ) * x( i, col );
+                }
+                x( row, col ) = sum / m_L( row, row );
+            }
+
+        return x;
+    }
+
+    template< int NUM_COLS >
+    FIXED_MATRIX< N, NUM_COLS > solve(
+        const FIXED_MATRIX< N, NUM_COLS > &b ) const
+    {
+        return backSolve( forwardSolve( b ) );
+    }
+
+    MHT_REAL mahalanobis( const FIXED_MATRIX< N, 1 > &v ) const
+    {
+        MHT_REAL y[ N ];
+        MHT_REAL sum;
+        MHT_REAL dist;
+        int row, i;
+
+        dist = 0.;
+        for( row = 0; row < N; row++ )
+        {
+            sum = v( row );
+            for( i = 0; i < row; i++ )
+            {
+                sum -= m_L( row, i ) * y[ i ];
+            }
+            y[ row ] = sum / m_L( row, row );
+            dist += y[ row ] * y[ row ];
+        }
+
+        return dist;
+    }
+
+    void print( int numSpaces = 0 ) const
+    {
+        m_L.print( numSpaces );
+    }
+};
+
+/*-------------------------------------------------------------------*
+ | FIXED_CHOLESKY< 2 > -- closed form for 2 x 2 matrices
+ |
+ | mahalanobis() does the same operations, in the same order, as
+ | GateReports2D() (see gate.H), so a model and the gate get exactly
+ | the same distances.
+ *-------------------------------------------------------------------*/
+
+template<>
+class FIXED_CHOLESKY< 2 >
+{
+private:
+
+    MHT_REAL m_l[ 3 ];               // L( 0, 0 ), L( 1, 0 ), L( 1, 1 )
+
+public:
+
+    FIXED_CHOLESKY()
+    {
+    }
+
+    template< class EXPR >
+    FIXED_CHOLESKY( const FIXED_EXPR< EXPR > &src )
+    {
+        static_assert( (int)EXPR::ROWS == 2 && (int)EXPR::COLS == 2,
+                       "matrix sizes don't match" );
+
+        const EXPR &m0 = src.expr();
+
+#ifdef TSTBUG
+        assert( m0( 0, 0 ) > 0 );
+#endif
+
+        m_l[ 0 ] = sqrt( m0( 0, 0 ) );
+        m_l[ 1 ] = m0( 1, 0 ) / m_l[ 0 ];
+        m_l[ 2 ] = sqrt( m0( 1, 1 ) - m_l[ 1 ] * m_l[ 1 ] );
+    }
+
+    MHT_REAL *getData()
+    {
+        return m_l;
+    }
+    const MHT_REAL *getData() const
+    {
+        return m_l;
+    }
+
+    MHT_REAL logDet() const
+    {
+        return 2. * log( m_l[ 0 ] * m_l[ 2 ] );
+    }
+
+    template< int NUM_COLS >
+    FIXED_MATRIX< 2, NUM_COLS > forwardSolve(
+        const FIXED_MATRIX< 2, NUM_COLS > &b ) const
+    {
+        FIXED_MATRIX< 2, NUM_COLS > y;
+        int col;
+
+        for( col = 0; col < NUM_COLS; col++ )
+        {
+            y( 0, col ) = b( 0, col ) / m_l[ 0 ];
+            y( 1, col ) = (b( 1, col ) - m_l[ 1 ] * y( 0, col )) / m_l[ 2 ];
+        }
+
+        return y;
+    }
+
+    template< int NUM_COLS >
+    FIXED_MATRIX< 2, NUM_COLS > backSolve(
+        const FIXED_MATRIX< 2, NUM_COLS > &y ) const
+    {
+        FIXED_MATRIX< 2, NUM_COLS > x;
+        int col;
+
+        for( col = 0; col < NUM_COLS; col++ )
+        {
+            x( 1, col ) = y( 1, col ) / m_l[ 2 ];
+            x( 0, col ) = (y( 0, col ) - m_l[ 1 ] * x( 1, col )) / m_l[ 0 ];
+        }
+
+        return x;
+    }
+
+    template< int NUM_COLS >
+    FIXED_MATRIX< 2, NUM_COLS > solve(
+        const FIXED_MATRIX< 2, NUM_COLS > &b ) const
+    {
+        return backSolve( forwardSolve( b ) );
+    }
+
+    MHT_REAL mahalanobis( const FIXED_MATRIX< 2, 1 > &v ) const
+    {
+        MHT_REAL y0 = v( 0 ) / m_l[ 0 ];
+        MHT_REAL y1 = (v( 1 ) - m_l[ 1 ] * y0) / m_l[ 2 ];
+
+        return y0 * y0 + y1 * y1;
+    }
+
+    void print( int numSpaces = 0 ) const
+    {
+        double l[ 4 ];
+
+        l[ 0 ] = m_l[ 0 ];
+        l[ 1 ] = 0.;
+        l[ 2 ] = m_l[ 1 ];
+        l[ 3 ] = m_l[ 2 ];
+        PrintMatrixData( l, 2, 2, numSpaces );
+    }
+};
+
+#endif
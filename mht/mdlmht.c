@@ -52,29 +52,34 @@ void MDL_MHT::measureAndValidate(const std::list< CORNER > &newReports)
 
 
     PTR_INTO_ptrDLIST_OF< T_HYPO > tHypoPtr;
-    MDL_T_HYPO *tHypo;
     PTR_INTO_iDLIST_OF< REPORT > reportPtr;
     MDL_REPORT *report;
     MDL_ROOT_T_HYPO *root;
+    int haveGrid;
 
     /* get reports of measurements */
     measure(newReports);
 
+    haveGrid = buildReportGrid();
+
+    prepareLeafStates();
+
     /* loop through all the active track hypotheses (leaves of the track
        trees), making children for each one */
-    LOOP_DLIST( tHypoPtr, m_activeTHypoList )
+    if( getNumThreads() > 1 )
     {
-        tHypo = (MDL_T_HYPO *)tHypoPtr.get();
-
-        tHypo->makeDefaultChildren();
-
-        LOOP_DLIST( reportPtr, m_newReportList )
+        growTreesInParallel( haveGrid );
+    }
+    else
+    {
+        LOOP_DLIST( tHypoPtr, m_activeTHypoList )
         {
-            report = (MDL_REPORT *)reportPtr.get();
-            tHypo->makeChildrenFor( report );
+            growLeaf( (MDL_T_HYPO *)tHypoPtr.get(), haveGrid );
         }
     }
 
+    releaseGrownStates();
+
     /* make a new track tree for each reported measurement */
     LOOP_DLIST( reportPtr, m_newReportList )
     {
@@ -87,6 +92,426 @@ void MDL_MHT::measureAndValidate(const std::list< CORNER > &newReports)
     }
 }
 
+/*-------------------------------------------------------------------*
+ | MDL_MHT::buildReportGrid() -- put the new reports into
+ |                               m_reportGrid
+ |
+ | m_gridReports is filled in either way, but this returns 0 if some
+ | report has no position, in which case the grid can't be used for
+ | this scan.
+ *-------------------------------------------------------------------*/
+
+int MDL_MHT::buildReportGrid()
+{
+
+
+    PTR_INTO_iDLIST_OF< REPORT > reportPtr;
+    MDL_REPORT *report;
+    int haveGrid;
+    double x, y;
+    int i;
+
+    m_numNewReports = m_newReportList.getLength();
+    if( m_numNewReports == 0 )
+    {
+        return 0;
+    }
+
+    m_reportGrid.resize( m_numNewReports );
+    m_gridReports.resize( m_numNewReports );
+    m_gateScratch.resize( m_numNewReports );
+
+    haveGrid = 1;
+    i = 0;
+    LOOP_DLIST( reportPtr, m_newReportList )
+    {
+        report = (MDL_REPORT *)reportPtr.get();
+        m_gridReports[ i ] = report;
+
+        /* a report at an infinite or undefined position can't be
+           placed on the grid (and might pass any gate test) */
+        if( ! report->getPosition( &x, &y ) ||
+            ! std::isfinite( x ) || ! std::isfinite( y ) )
+        {
+            haveGrid = 0;
+        }
+        else
+        {
+            m_reportGrid.setPoint( i, x, y );
+        }
+        i++;
+    }
+
+    if( haveGrid )
+    {
+        m_reportGrid.build();
+    }
+
+    return haveGrid;
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::prepareLeafStates() -- hand the states of the active
+ |                                 T_HYPOs to their MODELs'
+ |                                 prepareStates()
+ |
+ | Each MODEL is told the scan's time step, and then gets its states
+ | in one call, in the order of m_activeTHypoList.
+ *-------------------------------------------------------------------*/
+
+void MDL_MHT::prepareLeafStates()
+{
+
+
+    PTR_INTO_ptrDLIST_OF< T_HYPO > tHypoPtr;
+    MDL_STATE *state;
+    MODEL *mdl;
+    int numStates;
+    int numForMdl;
+    int first, i;
+
+    numStates = m_activeTHypoList.getLength();
+    if( numStates == 0 )
+    {
+        return;
+    }
+
+    m_leafStates.resize( numStates );
+    m_mdlStates.resize( numStates );
+
+    numStates = 0;
+    LOOP_DLIST( tHypoPtr, m_activeTHypoList )
+    {
+        state = ((MDL_T_HYPO *)tHypoPtr.get())->getState();
+        if( state != 0 )
+        {
+            m_leafStates[ numStates++ ] = state;
+        }
+    }
+
+    /* collect the states of one MODEL at a time, crossing them off
+       m_leafStates as they're taken */
+    for( first = 0; first < numStates; first++ )
+    {
+        if( m_leafStates[ first ] == 0 )
+        {
+            continue;
+        }
+
+        mdl = m_leafStates[ first ]->getMdl();
+        numForMdl = 0;
+        for( i = first; i < numStates; i++ )
+            if( m_leafStates[ i ] != 0 &&
+                m_leafStates[ i ]->getMdl() == mdl )
+            {
+                m_mdlStates[ numForMdl++ ] = m_leafStates[ i ];
+                m_leafStates[ i ] = 0;
+            }
+
+        mdl->beginScan( getTimeStep() );
+        mdl->prepareStates( &m_mdlStates[ 0 ], numForMdl );
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::releaseGrownStates() -- let the MODELs free what they
+ |                                  kept for growing the states of
+ |                                  the active T_HYPOs
+ |
+ | Called once all the active T_HYPOs have their children, so none of
+ | them is a leaf any more.
+ *-------------------------------------------------------------------*/
+
+void MDL_MHT::releaseGrownStates()
+{
+
+
+    PTR_INTO_ptrDLIST_OF< T_HYPO > tHypoPtr;
+    MDL_STATE *state;
+
+    LOOP_DLIST( tHypoPtr, m_activeTHypoList )
+    {
+        state = ((MDL_T_HYPO *)tHypoPtr.get())->getState();
+        if( state != 0 )
+        {
+            m_reclaimedBytes += state->getMdl()->releaseState( state );
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::findCandidates() -- find the new reports that might
+ |                              validate to a leaf
+ |
+ | Returns -1 if all of them might.  Otherwise, the grid point
+ | numbers of the candidates are left at the start of scratch.hits,
+ | in increasing order, and the number of them is returned.  Since
+ | the gate box is usually only known once the leaf's state has been
+ | set up, this should be called after its default children have
+ | been made.
+ *-------------------------------------------------------------------*/
+
+int MDL_MHT::findCandidates( MDL_T_HYPO *tHypo, int haveGrid,
+                             MDL_GATE_SCRATCH &scratch )
+{
+
+
+    double xMin, yMin, xMax, yMax;
+    int numHits;
+    int numPassed;
+    int i;
+
+    if( ! haveGrid || ! tHypo->getGateBox( &xMin, &yMin, &xMax, &yMax ) )
+    {
+        return -1;
+    }
+
+    numHits = m_reportGrid.query( xMin, yMin, xMax, yMax, scratch.hits );
+    if( numHits == 0 )
+    {
+        return 0;
+    }
+
+    for( i = 0; i < numHits; i++ )
+    {
+        scratch.reports[ i ] = m_gridReports[ scratch.hits[ i ] ];
+        scratch.x[ i ] = m_reportGrid.getX( scratch.hits[ i ] );
+        scratch.y[ i ] = m_reportGrid.getY( scratch.hits[ i ] );
+    }
+
+    /* the distances aren't used here -- the model works them out
+       again for the few reports that get through */
+    numPassed = tHypo->gateReports( numHits, &scratch.reports[ 0 ],
+                                    &scratch.x[ 0 ], &scratch.y[ 0 ],
+                                    &scratch.passed[ 0 ],
+                                    &scratch.distances[ 0 ] );
+    if( numPassed < 0 )
+    {
+        return numHits;
+    }
+
+    /* passed[ i ] >= i, so this can be done in place */
+    for( i = 0; i < numPassed; i++ )
+    {
+        scratch.hits[ i ] = scratch.hits[ scratch.passed[ i ] ];
+    }
+
+    return numPassed;
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::growLeaf() -- make the children of one active T_HYPO
+ *-------------------------------------------------------------------*/
+
+void MDL_MHT::growLeaf( MDL_T_HYPO *tHypo, int haveGrid )
+{
+
+
+    int numCandidates;
+    int i;
+
+    if( tHypo->getState() != 0 )
+    {
+        growStateLeaf( (MDL_CONTINUE_T_HYPO *)tHypo, haveGrid );
+        return;
+    }
+
+    tHypo->makeDefaultChildren();
+
+    numCandidates = findCandidates( tHypo, haveGrid, m_gateScratch );
+    if( numCandidates < 0 )
+    {
+        for( i = 0; i < m_numNewReports; i++ )
+        {
+            tHypo->makeChildrenFor( m_gridReports[ i ] );
+        }
+    }
+    else
+    {
+        for( i = 0; i < numCandidates; i++ )
+        {
+            tHypo->makeChildrenFor(
+                m_gridReports[ m_gateScratch.hits[ i ] ] );
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::growTreesInParallel() -- make the children of all the
+ |                                   active T_HYPOs, using
+ |                                   the threads of m_workerPool
+ |
+ | The leaves are split into one contiguous range per thread, with
+ | the leaves of each tree kept together (updateActiveTHypoList()
+ | lists them a tree at a time).  The threads only work out the new
+ | states, which is where the time goes.  The T_HYPOs for them are
+ | then made here, leaf by leaf, in the same order as growLeaf()
+ | would make them.
+ *-------------------------------------------------------------------*/
+
+void MDL_MHT::growTreesInParallel( int haveGrid )
+{
+
+
+    PTR_INTO_ptrDLIST_OF< T_HYPO > tHypoPtr;
+    MDL_WORKER *worker;
+    int numThreads;
+    int numLeaves;
+    int numPerThread;
+    int firstLeaf, lastLeaf;
+    int w, i;
+
+    numLeaves = m_activeTHypoList.getLength();
+    if( numLeaves == 0 )
+    {
+        return;
+    }
+
+    m_leaves.resize( numLeaves );
+    m_leafFirstState.resize( numLeaves );
+    m_leafNumStates.resize( numLeaves );
+
+    i = 0;
+    LOOP_DLIST( tHypoPtr, m_activeTHypoList )
+    {
+        m_leaves[ i++ ] = (MDL_T_HYPO *)tHypoPtr.get();
+    }
+
+    /* divide up the leaves, moving each boundary forward to the
+       start of the next tree */
+    numThreads = getNumThreads();
+    m_workers.resize( numThreads );
+    numPerThread = (numLeaves + numThreads - 1) / numThreads;
+    firstLeaf = 0;
+    for( w = 0; w < numThreads; w++ )
+    {
+        lastLeaf = firstLeaf + numPerThread;
+        if( lastLeaf > numLeaves )
+        {
+            lastLeaf = numLeaves;
+        }
+        while( lastLeaf > firstLeaf && lastLeaf < numLeaves &&
+               m_leaves[ lastLeaf ]->getTree() ==
+               m_leaves[ lastLeaf - 1 ]->getTree() )
+        {
+            lastLeaf++;
+        }
+
+        m_workers[ w ].firstLeaf = firstLeaf;
+        m_workers[ w ].lastLeaf = lastLeaf;
+        m_workers[ w ].scratch.resize( m_numNewReports );
+        firstLeaf = lastLeaf;
+    }
+
+    /* this thread takes the first range, and the pool's helpers the
+       others (an empty range costs a helper nothing) */
+    m_workerPool.run( [ this, haveGrid ]( int part )
+                      {
+                          findNewStates( &m_workers[ part ], haveGrid );
+                      },
+                      numThreads );
+
+    /* make the T_HYPOs */
+    for( w = 0; w < numThreads; w++ )
+    {
+        worker = &m_workers[ w ];
+        for( i = worker->firstLeaf; i < worker->lastLeaf; i++ )
+        {
+            if( m_leafNumStates[ i ] < 0 )
+            {
+                growLeaf( m_leaves[ i ], haveGrid );
+            }
+            else
+            {
+                installLeafStates(
+                    (MDL_CONTINUE_T_HYPO *)m_leaves[ i ],
+                    worker->newStates.data() + m_leafFirstState[ i ],
+                    m_leafNumStates[ i ] );
+            }
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::findNewStates() -- work out the new states for one
+ |                             worker's range of leaves
+ |
+ | This runs in a pool thread, so it mustn't change anything but
+ | the worker and its own entries in m_leafFirstState and
+ | m_leafNumStates.  Leaves without states (ROOTs, DUMMYs), and
+ | leaves whose models aren't reentrant, are marked to be grown by
+ | growLeaf() afterward.
+ *-------------------------------------------------------------------*/
+
+void MDL_MHT::findNewStates( MDL_WORKER *worker, int haveGrid )
+{
+
+
+    MDL_STATE *state;
+    int firstState;
+    int i;
+
+    worker->newStates.clear();
+
+    for( i = worker->firstLeaf; i < worker->lastLeaf; i++ )
+    {
+        state = m_leaves[ i ]->getState();
+        if( state == 0 || ! state->getMdl()->isReentrant() )
+        {
+            m_leafNumStates[ i ] = -1;
+            continue;
+        }
+
+        firstState = worker->newStates.size();
+
+        findLeafStates( (MDL_CONTINUE_T_HYPO *)m_leaves[ i ], haveGrid,
+                        worker );
+
+        m_leafFirstState[ i ] = firstState;
+        m_leafNumStates[ i ] = worker->newStates.size() - firstState;
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::growStateLeaf() -- make the children of one active
+ |                             T_HYPO that has a state
+ | MDL_MHT::findLeafStates() -- work out the new states for one such
+ |                              leaf, in a worker's thread
+ | MDL_MHT::installLeafStates() -- make the children of one such leaf
+ |                                 from the states found by
+ |                                 findLeafStates()
+ |
+ | Here, the MODEL member functions are virtual calls, since the
+ | leaves' MODELs may be of any class.  MDL_MHT_T redefines these to
+ | call them through its final MODEL class.
+ *-------------------------------------------------------------------*/
+
+void MDL_MHT::growStateLeaf( MDL_CONTINUE_T_HYPO *tHypo, int haveGrid )
+{
+
+
+    growStateLeafWith( tHypo->getState()->getMdl(), tHypo, haveGrid );
+}
+
+void MDL_MHT::findLeafStates( MDL_CONTINUE_T_HYPO *tHypo, int haveGrid,
+                              MDL_WORKER *worker )
+{
+
+
+    findLeafStatesWith( tHypo->getState()->getMdl(), tHypo, haveGrid,
+                        worker );
+}
+
+void MDL_MHT::installLeafStates( MDL_CONTINUE_T_HYPO *tHypo,
+                                 MDL_NEW_STATE *newStates,
+                                 int numNewStates )
+{
+
+
+    installLeafStatesWith( tHypo->getState()->getMdl(), tHypo,
+                           newStates, numNewStates );
+}
+
 /*-------------------------------------------------------------------*
  | MDL_ROOT_T_HYPO::makeDefaultChildren() -- make the default
  |                                           children of a ROOT node
@@ -157,46 +582,16 @@ void MDL_DUMMY_T_HYPO::makeDefaultChildren()
  |                                               children for a
  |                                               CONTINUE node
  |
- | This makes the children that are not linked to a report.
+ | This makes the children that are not linked to a report.  The
+ | work is done by the member template of the same name, in
+ | "mdlmht.H".
  *-------------------------------------------------------------------*/
 
 void MDL_CONTINUE_T_HYPO::makeDefaultChildren()
 {
 
 
-    MODEL *mdl = m_state->getMdl();
-    double endLogLikelihood = mdl->getEndLogLikelihood( m_state );
-    double continueLogLikelihood =
-        mdl->getContinueLogLikelihood( m_state );
-    double skipLogLikelihood =
-        mdl->getSkipLogLikelihood( m_state );
-    MDL_STATE *state;
-    int numNewStates;
-    int i;
-
-    if( endLogLikelihood != -INFINITY )
-        installChild( new MDL_END_T_HYPO( m_mdlMht,
-                                          m_logLikelihood,
-                                          skipLogLikelihood,
-                                          endLogLikelihood ) );
-
-    if( continueLogLikelihood != -INFINITY )
-    {
-        numNewStates = mdl->beginNewStates( m_state, 0 );
-
-        for( i = 0; i < numNewStates; i++ )
-        {
-            state = mdl->getNewState( i, m_state, 0 );
-            if( state != 0 )
-                installChild( new MDL_SKIP_T_HYPO( m_mdlMht,
-                                                   m_logLikelihood,
-                                                   continueLogLikelihood,
-                                                   skipLogLikelihood,
-                                                   state ) );
-        }
-
-        mdl->endNewStates();
-    }
+    makeDefaultChildren( m_state->getMdl() );
 }
 
 /*-------------------------------------------------------------------*
@@ -210,27 +605,5 @@ void MDL_CONTINUE_T_HYPO::makeChildrenFor( MDL_REPORT *report )
 {
 
 
-    MODEL *mdl = m_state->getMdl();
-    double continueLogLikelihood =
-        mdl->getContinueLogLikelihood( m_state );
-    double detectLogLikelihood =
-        mdl->getDetectLogLikelihood( m_state );
-    MDL_STATE *state;
-    int numNewStates;
-    int i;
-
-    numNewStates = mdl->beginNewStates( m_state, report );
-
-    for( i = 0; i < numNewStates; i++ )
-    {
-        state = mdl->getNewState( i, m_state, report );
-        if( state != 0 )
-            installChild( new MDL_CONTINUE_T_HYPO( m_mdlMht,
-                                                   m_logLikelihood,
-                                                   continueLogLikelihood,
-                                                   detectLogLikelihood,
-                                                   state, report ) );
-    }
-
-    mdl->endNewStates();
+    makeChildrenFor( m_state->getMdl(), report );
 }
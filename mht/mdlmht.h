@@ -159,6 +159,72 @@
  *                                                                   *
  *       This is the opposite of getSkipLogLikelihood().             *
  *                                                                   *
+ *     int getGateBox( MDL_STATE *s, double *xMin, double *yMin,     *
+ *                     double *xMax, double *yMax )                  *
+ *                                                                   *
+ *       This is optional.  If the model can bound the positions of  *
+ *       the reports that could possibly validate to state s (see    *
+ *       MDL_REPORT::getPosition() below), it should fill in the     *
+ *       bounding box and return 1.  getNewState() will then only be *
+ *       called with reports inside the box.  The box must never be  *
+ *       smaller than the real validation gate, or tracks will be    *
+ *       lost.  The default returns 0, meaning that every report     *
+ *       should be tried.                                            *
+ *                                                                   *
+ *     int gateReports( MDL_STATE *s, int n, MDL_REPORT **reports,   *
+ *                      const MHT_REAL *x, const MHT_REAL *y,        *
+ *                      int *passed, MHT_REAL *distance )            *
+ *                                                                   *
+ *       This is optional, too.  It's given n reports from inside    *
+ *       the gate box, with their positions as separate arrays of x  *
+ *       and y coordinates (MHT_REAL's, see precision.H), and should *
+ *       apply the model's validation gate to all of them at once    *
+ *       (see gate.H).  The indices of the reports that might        *
+ *       validate to s go into passed[], in increasing order, with   *
+ *       their distances in distance[], and the number of them is    *
+ *       returned.  getNewState() will only be called with those     *
+ *       reports.  The default returns -1, which means every report  *
+ *       in the box should be tried.                                 *
+ *                                                                   *
+ *     void beginScan( double timeStep )                             *
+ *                                                                   *
+ *       This is optional, too.  Once per scan, before the MODEL's   *
+ *       states are grown, it's told the time since the previous     *
+ *       scan (see MHT::getTimeStep()), so that it can get ready to  *
+ *       predict its states that far ahead.  It's only called for    *
+ *       MODELs that have states to grow.  The default does nothing. *
+ *                                                                   *
+ *     void prepareStates( MDL_STATE **states, int n )               *
+ *                                                                   *
+ *       This is optional, too.  Once per scan, before anything else *
+ *       is asked about them, the MODEL is handed the states of all  *
+ *       the active leaves that use it, so that it can do the work   *
+ *       that doesn't depend on the reports (a Kalman prediction,    *
+ *       say) for all of them in one batch, instead of one state at  *
+ *       a time.  The default does nothing.                          *
+ *                                                                   *
+ *     size_t releaseState( MDL_STATE *s )                           *
+ *                                                                   *
+ *       This is optional, too.  Once the children of s's node have  *
+ *       been made, s is never grown again; it's only kept for its   *
+ *       likelihood, and for reporting its track.  So whatever the   *
+ *       MODEL worked out for growing it (in prepareStates(), say)   *
+ *       can be freed, and this is called, once per scan, for each   *
+ *       state that was grown.  It should return the number of bytes *
+ *       freed.  The MODEL must still be able to work the freed      *
+ *       values out again if it's asked about s later.  The default  *
+ *       does nothing, and returns 0.                                *
+ *                                                                   *
+ *     int isReentrant()                                             *
+ *                                                                   *
+ *       This should return 1 if all the above routines may be       *
+ *       called from several threads at once, for different states.  *
+ *       That rules out keeping anything between beginNewStates()    *
+ *       and endNewStates() in the MODEL object itself.  Only the    *
+ *       states of reentrant models are computed by worker threads   *
+ *       (see MDL_MHT::setNumThreads() below).  The default returns  *
+ *       0.                                                          *
+ *                                                                   *
  *                            MDL_STATE                              *
  *                                                                   *
  *   A MDL_STATE subclass contains a description of a state          *
@@ -216,6 +282,14 @@
  *       This should return the log of the likelihood that the       *
  *       MDL_REPORT was a false alarm.                               *
  *                                                                   *
+ *     virtual int getPosition( double *x, double *y )               *
+ *                                                                   *
+ *       This is optional.  It should fill in the position of the    *
+ *       report and return 1, if the report has one that the         *
+ *       MODEL's getGateBox() can be compared to.  The default       *
+ *       returns 0.  If any report in a scan has no position, every  *
+ *       report is tried against every track in that scan.           *
+ *                                                                   *
  *                                                                   *
  *                            MDL_MHT                                *
  *                                                                   *
@@ -250,6 +324,27 @@
  *   it inherits from the MHT class.  See "mht.H" for a discussion   *
  *   of this function.                                               *
  *                                                                   *
+ *   There are three more public member functions:                   *
+ *                                                                   *
+ *     void setNumThreads( int numThreads )                          *
+ *     int getNumThreads()                                           *
+ *       Grow the track trees with numThreads threads (the default   *
+ *       is 1).  The leaves are split between the threads a whole    *
+ *       tree at a time.  Each thread works out the new states for   *
+ *       its leaves, and the nodes holding those states are then put *
+ *       on the trees by one thread, in the same order as they would *
+ *       be with a single thread, so the results don't depend on the *
+ *       number of threads.  The extra numThreads - 1 threads are    *
+ *       started here and kept waiting between scans in a            *
+ *       WORKER_POOL (see workers.H).  measure() may also share out  *
+ *       the preparation of its reports among them, with             *
+ *       runInParallel( job, numParts ), for up to getNumThreads()   *
+ *       parts.                                                      *
+ *                                                                   *
+ *     long getReclaimedBytes()                                      *
+ *       The total number of bytes that the MODELs have reported     *
+ *       freeing in releaseState() (see above).                      *
+ *                                                                   *
  *   The following virtual member functions can be redefined for the *
  *   specific application:                                           *
  *                                                                   *
@@ -298,6 +393,22 @@
  *   called.  At most, the difference between t and the current      *
  *   time will be maxDepth.                                          *
  *                                                                   *
+ *                           MDL_MHT_T                               *
+ *                                                                   *
+ *   If all the track models are of one MODEL subclass, say MDL, a   *
+ *   subclass of MDL_MHT can be derived from MDL_MHT_T< MDL >        *
+ *   instead, whose constructor takes the same arguments.  It grows  *
+ *   the track trees in the same way, except that the MODEL member   *
+ *   functions called for each child node (beginNewStates(),         *
+ *   getNewState(), endNewStates() and the get...LogLikelihood()     *
+ *   functions) are called through an MDL pointer.  MDL must be      *
+ *   declared final, so the compiler can call them directly, and     *
+ *   inline them into the loops that make the children.              *
+ *                                                                   *
+ *   Every MDL_STATE's getMdl() must then return an MDL (this is     *
+ *   checked when TSTBUG is defined).  A tracker with more than one  *
+ *   class of MODEL should inherit from MDL_MHT.                     *
+ *                                                                   *
  * IMPLEMENTATION NOTES:                                             *
  *                                                                   *
  *   This stuff inherits from the classes in "mht.H", which          *
@@ -368,6 +479,15 @@
  *       state estimate into its MODEL with each report found by     *
  *       measure().                                                  *
  *                                                                   *
+ *   When the reports of a scan all have positions, they are put in  *
+ *   a REPORT_GRID (see rgrid.H) before the trees are grown.  A node *
+ *   whose MODEL gives a gate box for its state is then only offered *
+ *   the reports inside that box, in their original order, so the    *
+ *   trees come out the same as if every report had been tried.      *
+ *   The positions of the reports in the box are then copied into    *
+ *   contiguous arrays and handed to the MODEL's gateReports(), so   *
+ *   that it can screen them all in one pass.                        *
+ *                                                                   *
  * ----------------------------------------------------------------- *
  *                                                                   *
  *             Copyright (c) 1993, NEC Research Institute            *
@@ -400,8 +520,13 @@
 #define MDLMHT_H
 
 #include "mht.h"
+#include "precision.h"
+#include "rgrid.h"
 #include "corner.h"		// for CORNER class
+#include "workers.h"
 #include <list>			// for std::list<>
+#include <vector>		// for std::vector<>
+#include <type_traits>		// for std::is_final<>
 
 /*-------------------------------------------------------------------*
  | Stuff defined in this file
@@ -457,6 +582,37 @@ public:
     {
         return 0;
     }
+
+    virtual int getGateBox( MDL_STATE *, double *, double *,
+                            double *, double * )
+    {
+        return 0;
+    }
+
+    virtual int gateReports( MDL_STATE *, int, MDL_REPORT **,
+                             const MHT_REAL *, const MHT_REAL *,
+                             int *, MHT_REAL * )
+    {
+        return -1;
+    }
+
+    virtual void beginScan( double )
+    {
+    }
+
+    virtual void prepareStates( MDL_STATE **, int )
+    {
+    }
+
+    virtual size_t releaseState( MDL_STATE * )
+    {
+        return 0;
+    }
+
+    virtual int isReentrant()
+    {
+        return 0;
+    }
 };
 
 /*-------------------------------------------------------------------*
@@ -518,6 +674,59 @@ public:
     {
         return -INFINITY;
     }
+
+    virtual int getPosition( double *, double * )
+    {
+        return 0;
+    }
+};
+
+/*-------------------------------------------------------------------*
+ | MDL_NEW_STATE -- a state made by a MODEL, waiting for a node to be
+ |                  made for it (see MDL_MHT::growTreesInParallel())
+ *-------------------------------------------------------------------*/
+
+struct MDL_NEW_STATE
+{
+    MDL_STATE *state;
+    MDL_REPORT *report;                  // 0 for a SKIP node
+};
+
+/*-------------------------------------------------------------------*
+ | MDL_GATE_SCRATCH -- buffers used in finding the reports that might
+ |                     validate to one node
+ *-------------------------------------------------------------------*/
+
+struct MDL_GATE_SCRATCH
+{
+    VECTOR_OF< int > hits;               // grid points of the reports
+    VECTOR_OF< MDL_REPORT * > reports;   // the reports in hits, and
+    VECTOR_OF< MHT_REAL > x;             //   their positions
+    VECTOR_OF< MHT_REAL > y;
+    VECTOR_OF< int > passed;             // results of gateReports()
+    VECTOR_OF< MHT_REAL > distances;
+
+    void resize( int numReports )
+    {
+        hits.resize( numReports );
+        reports.resize( numReports );
+        x.resize( numReports );
+        y.resize( numReports );
+        passed.resize( numReports );
+        distances.resize( numReports );
+    }
+};
+
+/*-------------------------------------------------------------------*
+ | MDL_WORKER -- what one thread does in growing the track trees
+ *-------------------------------------------------------------------*/
+
+struct MDL_WORKER
+{
+    int firstLeaf;                       // range of leaves to grow
+    int lastLeaf;                        //   (lastLeaf not included)
+    std::vector< MDL_NEW_STATE > newStates;
+    MDL_GATE_SCRATCH scratch;
 };
 
 /*-------------------------------------------------------------------*
@@ -538,21 +747,107 @@ protected:
 
     ptrDLIST_OF< MODEL > m_modelList;
 
+private:
+
+    int m_numNewReports;
+    REPORT_GRID m_reportGrid;            // positions of the reports in
+                                         //   m_newReportList, for gating
+    VECTOR_OF< MDL_REPORT * > m_gridReports; // reports in m_newReportList,
+                                         //   by grid point number
+    MDL_GATE_SCRATCH m_gateScratch;
+
+    WORKER_POOL m_workerPool;
+    VECTOR_OF< MDL_WORKER > m_workers;
+    VECTOR_OF< MDL_T_HYPO * > m_leaves;  // m_activeTHypoList, as an array
+    VECTOR_OF< int > m_leafFirstState;   // where each leaf's states are
+    VECTOR_OF< int > m_leafNumStates;    //   in its worker's newStates
+                                         //   (-1 if it isn't done by a
+                                         //   worker)
+    VECTOR_OF< MDL_STATE * > m_leafStates; // states of the leaves, and
+    VECTOR_OF< MDL_STATE * > m_mdlStates; //   the ones for one MODEL
+                                         //   (see prepareLeafStates())
+    long m_reclaimedBytes;               // total freed by
+                                         //   MODEL::releaseState()
+
 public:
 
     MDL_MHT( int maxDepth, double minGHypoRatio, int maxGHypos ):
         MHT( maxDepth, minGHypoRatio, maxGHypos ),
-        m_modelList()
+        m_modelList(),
+        m_numNewReports( 0 ),
+        m_reportGrid(),
+        m_gridReports(),
+        m_gateScratch(),
+        m_workerPool(),
+        m_workers(),
+        m_leaves(),
+        m_leafFirstState(),
+        m_leafNumStates(),
+        m_leafStates(),
+        m_mdlStates(),
+        m_reclaimedBytes( 0 )
     {
     }
 
     virtual ~MDL_MHT() {}
 
+    void setNumThreads( int numThreads )
+    {
+        m_workerPool.setNumThreads( numThreads );
+    }
+    int getNumThreads()
+    {
+        return m_workerPool.getNumThreads();
+    }
+    long getReclaimedBytes()
+    {
+        return m_reclaimedBytes;
+    }
+
 protected:
 
     virtual void measure(const std::list<CORNER> &newReports) {}
     virtual void measureAndValidate(const std::list<CORNER> &newReports);
 
+    void runInParallel( const std::function< void( int ) > &job,
+                        int numParts )
+    {
+        m_workerPool.run( job, numParts );
+    }
+
+private:
+
+    int buildReportGrid();
+    void prepareLeafStates();
+    int findCandidates( MDL_T_HYPO *tHypo, int haveGrid,
+                        MDL_GATE_SCRATCH &scratch );
+    void growLeaf( MDL_T_HYPO *tHypo, int haveGrid );
+    void growTreesInParallel( int haveGrid );
+    void releaseGrownStates();
+    void findNewStates( MDL_WORKER *worker, int haveGrid );
+
+protected:
+
+    /* growing the leaves that have states (see MDL_MHT_T) */
+    virtual void growStateLeaf( MDL_CONTINUE_T_HYPO *tHypo,
+                                int haveGrid );
+    virtual void findLeafStates( MDL_CONTINUE_T_HYPO *tHypo,
+                                 int haveGrid, MDL_WORKER *worker );
+    virtual void installLeafStates( MDL_CONTINUE_T_HYPO *tHypo,
+                                    MDL_NEW_STATE *newStates,
+                                    int numNewStates );
+
+    template< class MDL >
+    void growStateLeafWith( MDL *mdl, MDL_CONTINUE_T_HYPO *tHypo,
+                            int haveGrid );
+    template< class MDL >
+    void findLeafStatesWith( MDL *mdl, MDL_CONTINUE_T_HYPO *tHypo,
+                             int haveGrid, MDL_WORKER *worker );
+    template< class MDL >
+    void installLeafStatesWith( MDL *mdl, MDL_CONTINUE_T_HYPO *tHypo,
+                                MDL_NEW_STATE *newStates,
+                                int numNewStates );
+
     virtual void startTrack( int, int,
                              MDL_STATE *, MDL_REPORT * )
     {
@@ -620,6 +915,17 @@ protected:
     virtual void makeDefaultChildren() {}
     virtual void makeChildrenFor( MDL_REPORT * ) {}
 
+    virtual int getGateBox( double *, double *, double *, double * )
+    {
+        return 0;
+    }
+    virtual int gateReports( int, MDL_REPORT **,
+                             const MHT_REAL *, const MHT_REAL *,
+                             int *, MHT_REAL * )
+    {
+        return -1;
+    }
+
 public:
 
     virtual MDL_STATE *getState()
@@ -784,6 +1090,36 @@ protected:
 
     virtual void makeDefaultChildren();
     virtual void makeChildrenFor( MDL_REPORT *report );
+    virtual int getGateBox( double *xMin, double *yMin,
+                            double *xMax, double *yMax )
+    {
+        return m_state->getMdl()->getGateBox( m_state,
+                                              xMin, yMin, xMax, yMax );
+    }
+    virtual int gateReports( int n, MDL_REPORT **reports,
+                             const MHT_REAL *x, const MHT_REAL *y,
+                             int *passed, MHT_REAL *distance )
+    {
+        return m_state->getMdl()->gateReports( m_state, n, reports, x, y,
+                                               passed, distance );
+    }
+
+    /* the work of the above, and of MDL_MHT::growTreesInParallel(),
+       with m_state's MODEL given as an MDL (defined below) */
+    template< class MDL >
+    void makeDefaultChildren( MDL *mdl );
+    template< class MDL >
+    void makeChildrenFor( MDL *mdl, MDL_REPORT *report );
+    template< class MDL >
+    void findDefaultStates( MDL *mdl,
+                            std::vector< MDL_NEW_STATE > &newStates );
+    template< class MDL >
+    void findStatesFor( MDL *mdl, MDL_REPORT *report,
+                        std::vector< MDL_NEW_STATE > &newStates );
+    template< class MDL >
+    void installNewStates( MDL *mdl,
+                           MDL_NEW_STATE *newStates, int numNewStates );
+
     virtual void verify()
     {
         m_mdlMht->continueTrack( getTrackStamp(), getTimeStamp(),
@@ -925,4 +1261,357 @@ public:
     }
 };
 
+/*-------------------------------------------------------------------*
+ | Member templates of MDL_CONTINUE_T_HYPO and MDL_MHT
+ |
+ | These are instantiated with MDL = MODEL by MDL_MHT, and with the
+ | final MODEL subclass by MDL_MHT_T.
+ *-------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------*
+ | MDL_CONTINUE_T_HYPO::makeDefaultChildren() -- make default
+ |                                               children for a
+ |                                               CONTINUE node
+ |
+ | This makes the children that are not linked to a report.
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+void MDL_CONTINUE_T_HYPO::makeDefaultChildren( MDL *mdl )
+{
+
+
+    double endLogLikelihood = mdl->getEndLogLikelihood( m_state );
+    double continueLogLikelihood =
+        mdl->getContinueLogLikelihood( m_state );
+    double skipLogLikelihood =
+        mdl->getSkipLogLikelihood( m_state );
+    MDL_STATE *state;
+    int numNewStates;
+    int i;
+
+    if( endLogLikelihood != -INFINITY )
+        installChild( new MDL_END_T_HYPO( m_mdlMht,
+                                          m_logLikelihood,
+                                          skipLogLikelihood,
+                                          endLogLikelihood ) );
+
+    if( continueLogLikelihood != -INFINITY )
+    {
+        numNewStates = mdl->beginNewStates( m_state, 0 );
+
+        for( i = 0; i < numNewStates; i++ )
+        {
+            state = mdl->getNewState( i, m_state, 0 );
+            if( state != 0 )
+                installChild( new MDL_SKIP_T_HYPO( m_mdlMht,
+                                                   m_logLikelihood,
+                                                   continueLogLikelihood,
+                                                   skipLogLikelihood,
+                                                   state ) );
+        }
+
+        mdl->endNewStates();
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_CONTINUE_T_HYPO::makeChildrenFor() -- make children for a
+ |                                           CONTINUE node
+ |
+ | This makes the children that ARE linked to a report.
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+void MDL_CONTINUE_T_HYPO::makeChildrenFor( MDL *mdl, MDL_REPORT *report )
+{
+
+
+    double continueLogLikelihood =
+        mdl->getContinueLogLikelihood( m_state );
+    double detectLogLikelihood =
+        mdl->getDetectLogLikelihood( m_state );
+    MDL_STATE *state;
+    int numNewStates;
+    int i;
+
+    numNewStates = mdl->beginNewStates( m_state, report );
+
+    for( i = 0; i < numNewStates; i++ )
+    {
+        state = mdl->getNewState( i, m_state, report );
+        if( state != 0 )
+            installChild( new MDL_CONTINUE_T_HYPO( m_mdlMht,
+                                                   m_logLikelihood,
+                                                   continueLogLikelihood,
+                                                   detectLogLikelihood,
+                                                   state, report ) );
+    }
+
+    mdl->endNewStates();
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_CONTINUE_T_HYPO::findDefaultStates() -- find the states of the
+ |                                             default children of a
+ |                                             CONTINUE node
+ |
+ | The states are appended to newStates, for installNewStates().
+ | This makes no T_HYPOs, so it can be run in a worker thread.
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+void MDL_CONTINUE_T_HYPO::findDefaultStates(
+    MDL *mdl,
+    std::vector< MDL_NEW_STATE > &newStates )
+{
+
+
+    MDL_NEW_STATE newState;
+    int numNewStates;
+    int i;
+
+    if( mdl->getContinueLogLikelihood( m_state ) == -INFINITY )
+    {
+        return;
+    }
+
+    numNewStates = mdl->beginNewStates( m_state, 0 );
+
+    for( i = 0; i < numNewStates; i++ )
+    {
+        newState.state = mdl->getNewState( i, m_state, 0 );
+        newState.report = 0;
+        if( newState.state != 0 )
+            newStates.push_back( newState );
+    }
+
+    mdl->endNewStates();
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_CONTINUE_T_HYPO::findStatesFor() -- find the states of the
+ |                                         children of a CONTINUE
+ |                                         node for a report
+ |
+ | Like findDefaultStates(), this makes no T_HYPOs.
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+void MDL_CONTINUE_T_HYPO::findStatesFor(
+    MDL *mdl,
+    MDL_REPORT *report,
+    std::vector< MDL_NEW_STATE > &newStates )
+{
+
+
+    MDL_NEW_STATE newState;
+    int numNewStates;
+    int i;
+
+    numNewStates = mdl->beginNewStates( m_state, report );
+
+    for( i = 0; i < numNewStates; i++ )
+    {
+        newState.state = mdl->getNewState( i, m_state, report );
+        newState.report = report;
+        if( newState.state != 0 )
+            newStates.push_back( newState );
+    }
+
+    mdl->endNewStates();
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_CONTINUE_T_HYPO::installNewStates() -- make the children of a
+ |                                            CONTINUE node from the
+ |                                            states found by
+ |                                            findDefaultStates() and
+ |                                            findStatesFor()
+ |
+ | The children are made in the same order, and with the same
+ | likelihoods, as makeDefaultChildren() and makeChildrenFor() would
+ | make them.
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+void MDL_CONTINUE_T_HYPO::installNewStates( MDL *mdl,
+                                            MDL_NEW_STATE *newStates,
+                                            int numNewStates )
+{
+
+
+    double endLogLikelihood = mdl->getEndLogLikelihood( m_state );
+    double continueLogLikelihood =
+        mdl->getContinueLogLikelihood( m_state );
+    double skipLogLikelihood =
+        mdl->getSkipLogLikelihood( m_state );
+    double detectLogLikelihood =
+        mdl->getDetectLogLikelihood( m_state );
+    int i;
+
+    if( endLogLikelihood != -INFINITY )
+        installChild( new MDL_END_T_HYPO( m_mdlMht,
+                                          m_logLikelihood,
+                                          skipLogLikelihood,
+                                          endLogLikelihood ) );
+
+    for( i = 0; i < numNewStates; i++ )
+    {
+        if( newStates[ i ].report == 0 )
+            installChild( new MDL_SKIP_T_HYPO( m_mdlMht,
+                                               m_logLikelihood,
+                                               continueLogLikelihood,
+                                               skipLogLikelihood,
+                                               newStates[ i ].state ) );
+        else
+            installChild( new MDL_CONTINUE_T_HYPO( m_mdlMht,
+                                                   m_logLikelihood,
+                                                   continueLogLikelihood,
+                                                   detectLogLikelihood,
+                                                   newStates[ i ].state,
+                                                   newStates[ i ].report ) );
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::growStateLeafWith() -- make the children of one active
+ |                                 T_HYPO that has a state
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+void MDL_MHT::growStateLeafWith( MDL *mdl, MDL_CONTINUE_T_HYPO *tHypo,
+                                 int haveGrid )
+{
+
+
+    int numCandidates;
+    int i;
+
+    tHypo->makeDefaultChildren( mdl );
+
+    numCandidates = findCandidates( tHypo, haveGrid, m_gateScratch );
+    if( numCandidates < 0 )
+    {
+        for( i = 0; i < m_numNewReports; i++ )
+        {
+            tHypo->makeChildrenFor( mdl, m_gridReports[ i ] );
+        }
+    }
+    else
+    {
+        for( i = 0; i < numCandidates; i++ )
+        {
+            tHypo->makeChildrenFor( mdl,
+                m_gridReports[ m_gateScratch.hits[ i ] ] );
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::findLeafStatesWith() -- work out the new states for one
+ |                                  leaf, in a worker's thread
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+void MDL_MHT::findLeafStatesWith( MDL *mdl, MDL_CONTINUE_T_HYPO *tHypo,
+                                  int haveGrid, MDL_WORKER *worker )
+{
+
+
+    int numCandidates;
+    int j;
+
+    tHypo->findDefaultStates( mdl, worker->newStates );
+
+    numCandidates = findCandidates( tHypo, haveGrid, worker->scratch );
+    if( numCandidates < 0 )
+    {
+        for( j = 0; j < m_numNewReports; j++ )
+        {
+            tHypo->findStatesFor( mdl, m_gridReports[ j ],
+                                  worker->newStates );
+        }
+    }
+    else
+    {
+        for( j = 0; j < numCandidates; j++ )
+        {
+            tHypo->findStatesFor(
+                mdl,
+                m_gridReports[ worker->scratch.hits[ j ] ],
+                worker->newStates );
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT::installLeafStatesWith() -- make the children of one leaf
+ |                                     from the states found by
+ |                                     findLeafStatesWith()
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+void MDL_MHT::installLeafStatesWith( MDL *mdl, MDL_CONTINUE_T_HYPO *tHypo,
+                                     MDL_NEW_STATE *newStates,
+                                     int numNewStates )
+{
+
+
+    tHypo->installNewStates( mdl, newStates, numNewStates );
+}
+
+/*-------------------------------------------------------------------*
+ | MDL_MHT_T -- MDL_MHT for track models of the one final class MDL
+ *-------------------------------------------------------------------*/
+
+template< class MDL >
+class MDL_MHT_T: public MDL_MHT
+{
+    static_assert( std::is_base_of< MODEL, MDL >::value,
+                   "MDL_MHT_T<> needs a subclass of MODEL" );
+    static_assert( std::is_final< MDL >::value,
+                   "MDL_MHT_T<> needs a final MODEL class" );
+
+public:
+
+    MDL_MHT_T( int maxDepth, double minGHypoRatio, int maxGHypos ):
+        MDL_MHT( maxDepth, minGHypoRatio, maxGHypos )
+    {
+    }
+
+protected:
+
+    virtual void growStateLeaf( MDL_CONTINUE_T_HYPO *tHypo,
+                                int haveGrid )
+    {
+        growStateLeafWith( getMdl( tHypo ), tHypo, haveGrid );
+    }
+    virtual void findLeafStates( MDL_CONTINUE_T_HYPO *tHypo,
+                                 int haveGrid, MDL_WORKER *worker )
+    {
+        findLeafStatesWith( getMdl( tHypo ), tHypo, haveGrid, worker );
+    }
+    virtual void installLeafStates( MDL_CONTINUE_T_HYPO *tHypo,
+                                    MDL_NEW_STATE *newStates,
+                                    int numNewStates )
+    {
+        installLeafStatesWith( getMdl( tHypo ), tHypo,
+                               newStates, numNewStates );
+    }
+
+private:
+
+    static MDL *getMdl( MDL_CONTINUE_T_HYPO *tHypo )
+    {
+        MODEL *mdl = tHypo->getState()->getMdl();
+
+#ifdef TSTBUG
+        assert( dynamic_cast< MDL * >( mdl ) != 0 );
+#endif
+
+        return static_cast< MDL * >( mdl );
+    }
+};
+
 #endif
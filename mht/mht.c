@@ -60,6 +60,8 @@ int MHT::scan()
     const CORNERLIST newReports = m_reportsQueue.front();
     m_reportsQueue.pop();
 
+    m_timeStep = newReports.m_dT;
+    T_HYPO::getArena().beginEpoch();
     measureAndValidate(newReports.list);
     m_currentTime++;
 
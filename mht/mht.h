@@ -142,6 +142,13 @@
  *       example, one representing the possibility that the reported *
  *       measurement resulted from this target.                      *
  *                                                                   *
+ *   T_HYPO's must be made with new.  Their memory comes from an     *
+ *   EPOCH_ARENA (see arena.H), with a new epoch begun by each call  *
+ *   to MHT::scan().  So the nodes of one scan lie together in       *
+ *   memory, and their slabs are reused once pruning has deleted     *
+ *   them all.  T_HYPO's should only be made and deleted by the      *
+ *   thread that calls scan().                                       *
+ *                                                                   *
  *   The following member functions for T_HYPO's are public:         *
  *                                                                   *
  *     void installChild( T_HYPO *c )                                *
@@ -324,6 +331,13 @@
  *       Returns a count of the number of calls that have been made  *
  *       to scan() since the MHT was created.                        *
  *                                                                   *
+ *     double getTimeStep()                                          *
+ *                                                                   *
+ *       Returns the time between the current scan and the previous  *
+ *       one, taken from the m_dT of the CORNERLIST the scan's       *
+ *       reports came in (see addReports()).  Scans needn't be       *
+ *       evenly spaced.                                              *
+ *                                                                   *
  *     int scan()                                                    *
  *                                                                   *
  *       See the beginning of these comments for a description.      *
@@ -415,6 +429,10 @@
  *   Any internal node that no longer has any children (because they *
  *   were removed) is now removed.                                   *
  *                                                                   *
+ *   Since a whole new set of G_HYPOs is made for every GROUP in     *
+ *   every scan, their memory is recycled through a POOL_OF<> (see   *
+ *   pool.H) instead of going back to the heap.                      *
+ *                                                                   *
  * ----------------------------------------------------------------- *
  *                                                                   *
  *             Copyright (c) 1993, NEC Research Institute            *
@@ -456,6 +474,8 @@
 #include "tree.h"
 #include "links.h"
 #include "vector.h"
+#include "arena.h"
+#include "pool.h"
 #include <list>			// for std::list<>
 #include "corner.h"		// for CORNER, CORNERLIST
 #include <queue>		// for std::queue<>
@@ -615,6 +635,15 @@ protected:
 
 public:
 
+    static void *operator new( size_t size )
+    {
+        return getArena().alloc( size );
+    }
+    static void operator delete( void *block )
+    {
+        getArena().free( block );
+    }
+
     void installChild( T_HYPO *child )
     {
         PTR_INTO_iTREE_OF< T_HYPO > p = this;
@@ -684,6 +713,13 @@ private:
         return TREEnode::getNumChildren();
     }
 
+    static EPOCH_ARENA &getArena()
+    {
+        static EPOCH_ARENA *arena = new EPOCH_ARENA;
+
+        return *arena;
+    }
+
     void setStamps( T_TREE *tree, int timeStamp )
     {
         m_tree = tree;
@@ -759,6 +795,15 @@ public:
 
     G_HYPO( VECTOR_OF< void * > &solution, int solutionSize );
 
+    static void *operator new( size_t size )
+    {
+        return POOL_OF< G_HYPO >::alloc( size );
+    }
+    static void operator delete( void *block, size_t size )
+    {
+        POOL_OF< G_HYPO >::free( block, size );
+    }
+
     int isInUse()
     {
         return ! m_tHypoLinks.isEmpty();
@@ -952,6 +997,7 @@ protected:
 
     int m_lastTrackIdUsed;
     int m_currentTime;
+    double m_timeStep;               // time since the previous scan
 
     int m_maxDepth;
     double m_logMinGHypoRatio;
@@ -973,6 +1019,7 @@ protected:
     MHT( int maxDepth, double minGHypoRatio, int maxGHypos ):
         m_lastTrackIdUsed( 0 ),
         m_currentTime( 0 ),
+        m_timeStep( 1. ),
         m_maxDepth( maxDepth ),
         m_logMinGHypoRatio( log( minGHypoRatio ) ),
         m_maxGHypos( maxGHypos ),
@@ -1031,6 +1078,10 @@ public:
     {
         return m_currentTime;
     }
+    double getTimeStep()
+    {
+        return m_timeStep;
+    }
 
     void addReports(const CORNERLIST &newReport);
     int scan();
@@ -901,6 +901,14 @@ void G_HYPO::nScanBackPrune( int maxDepth )
 /*-------------------------------------------------------------------*
  | G_HYPO::recomputeLogLikelihood() -- make sure the log likelihood
  |                                     of the G_HYPO is up to date
+ |
+ | addTHypo() and split() keep m_logLikelihood up to date, but they
+ | sum the T_HYPOs in a different order than this does, so the two
+ | can differ in the last bit or two.  GROUP::merge() sorts G_HYPOs
+ | by likelihood, and where many of them are equally likely (as in
+ | the Toy sequence) that's enough to change which ones are kept.
+ | So merge() recomputes them first, rather than trusting the
+ | running sums.
  *-------------------------------------------------------------------*/
 
 void G_HYPO::recomputeLogLikelihood()
@@ -0,0 +1,205 @@
+
+/*********************************************************************
+ * FILE: pool.H                                                      *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Template for recycling the memory of many small objects of one  *
+ *   type, which are made and destroyed at a high rate (the states   *
+ *   of a model, for instance).                                      *
+ *                                                                   *
+ *   The template is used by giving a class its own operator new()   *
+ *   and operator delete():                                          *
+ *                                                                   *
+ *     static void *operator new( size_t size )                      *
+ *     {                                                             *
+ *         return POOL_OF< type >::alloc( size );                    *
+ *     }                                                             *
+ *     static void operator delete( void *block, size_t size )       *
+ *     {                                                             *
+ *         POOL_OF< type >::free( block, size );                     *
+ *     }                                                             *
+ *                                                                   *
+ *   Where                                                           *
+ *                                                                   *
+ *     type = the class                                              *
+ *                                                                   *
+ *   Memory is taken from the heap in slabs of SLAB_SIZE objects,    *
+ *   and a freed object's memory goes onto a free list to be handed  *
+ *   out again, instead of back to the heap.  Slabs are never given  *
+ *   back, so objects may still be freed while static objects are    *
+ *   being destroyed at exit.  A request for any other size (a       *
+ *   subclass that doesn't have its own pool) goes to the heap as    *
+ *   usual, so the class's destructor must be virtual if it has      *
+ *   subclasses.                                                     *
+ *                                                                   *
+ *   The pool may be used from several threads at once.  Each thread *
+ *   keeps a free list of its own, and only takes the pool's lock to *
+ *   move BATCH_SIZE objects at a time between it and the pool's     *
+ *   list, so objects made by one thread and freed by another (as    *
+ *   when worker threads grow a tree that the main thread prunes)    *
+ *   still get recycled.                                             *
+ *                                                                   *
+ *********************************************************************/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <mutex>
+#include <new>
+#include <vector>
+
+template< class TYPE >
+class POOL_OF
+{
+private:
+
+    enum { SLAB_SIZE = 256, BATCH_SIZE = 64 };
+
+    union BLOCK
+    {
+        BLOCK *next;
+        alignas( TYPE ) char data[ sizeof( TYPE ) ];
+    };
+
+    struct SHARED                    // free list and slabs of the pool
+    {
+        std::mutex mutex;
+        BLOCK *freeList;
+        std::vector< BLOCK * > slabs;
+
+        SHARED(): mutex(), freeList( 0 ), slabs() {}
+    };
+
+    struct CACHE                     // free list of one thread
+    {
+        BLOCK *freeList;
+        int numFree;
+
+        CACHE(): freeList( 0 ), numFree( 0 ) {}
+
+        ~CACHE()
+        {
+            while( numFree > 0 )
+            {
+                giveBack( *this );
+            }
+        }
+    };
+
+    static thread_local CACHE s_cache;
+
+    static SHARED &getShared()
+    {
+        static SHARED *shared = new SHARED;
+
+        return *shared;
+    }
+
+    /* move up to BATCH_SIZE blocks from the pool's free list to
+       cache's, making a new slab if the pool's is empty */
+    static void takeBatch( CACHE &cache )
+    {
+        SHARED &shared = getShared();
+        std::lock_guard< std::mutex > lock( shared.mutex );
+        BLOCK *block;
+        int i;
+
+        if( shared.freeList == 0 )
+        {
+            BLOCK *slab = new BLOCK[ SLAB_SIZE ];
+
+            shared.slabs.push_back( slab );
+            for( i = 0; i < SLAB_SIZE - 1; i++ )
+            {
+                slab[ i ].next = &slab[ i + 1 ];
+            }
+            slab[ SLAB_SIZE - 1 ].next = 0;
+            shared.freeList = slab;
+        }
+
+        for( i = 0; i < BATCH_SIZE && shared.freeList != 0; i++ )
+        {
+            block = shared.freeList;
+            shared.freeList = block->next;
+            block->next = cache.freeList;
+            cache.freeList = block;
+            cache.numFree++;
+        }
+    }
+
+    /* move up to BATCH_SIZE blocks from cache's free list back to
+       the pool's */
+    static void giveBack( CACHE &cache )
+    {
+        SHARED &shared = getShared();
+        std::lock_guard< std::mutex > lock( shared.mutex );
+        BLOCK *block;
+        int i;
+
+        for( i = 0; i < BATCH_SIZE && cache.freeList != 0; i++ )
+        {
+            block = cache.freeList;
+            cache.freeList = block->next;
+            cache.numFree--;
+            block->next = shared.freeList;
+            shared.freeList = block;
+        }
+    }
+
+public:
+
+    static void *alloc( size_t size )
+    {
+        CACHE &cache = s_cache;
+        BLOCK *block;
+
+        if( size != sizeof( TYPE ) )
+        {
+            return ::operator new( size );
+        }
+
+        if( cache.freeList == 0 )
+        {
+            takeBatch( cache );
+        }
+
+        block = cache.freeList;
+        cache.freeList = block->next;
+        cache.numFree--;
+
+        return block;
+    }
+
+    static void free( void *ptr, size_t size )
+    {
+        CACHE &cache = s_cache;
+        BLOCK *block = (BLOCK *)ptr;
+
+        if( ptr == 0 )
+        {
+            return;
+        }
+
+        if( size != sizeof( TYPE ) )
+        {
+            ::operator delete( ptr );
+            return;
+        }
+
+        block->next = cache.freeList;
+        cache.freeList = block;
+        cache.numFree++;
+
+        if( cache.numFree > 2 * BATCH_SIZE )
+        {
+            giveBack( cache );
+        }
+    }
+};
+
+template< class TYPE >
+thread_local typename POOL_OF< TYPE >::CACHE POOL_OF< TYPE >::s_cache;
+
+#endif
@@ -0,0 +1,38 @@
+/*********************************************************************
+ * FILE: precision.H                                                 *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   MHT_REAL -- the floating-point type of the numbers that the     *
+ *   tracker keeps in bulk: the entries of FIXED_MATRIX's (and so    *
+ *   the state estimates and covariances of a Kalman filter model),  *
+ *   the report positions and distances handed to the gating         *
+ *   kernel (see gate.H), and the costs in assignment problems (see  *
+ *   ROW_COL_COST in assign.H).                                      *
+ *                                                                   *
+ *   Normally it's double.  If MHT_SINGLE_PRECISION is defined (it   *
+ *   must be defined the same way for the mht library and for the    *
+ *   program using it), it's float, which halves the size of those   *
+ *   numbers, so twice as many fit in a cache line or a vector       *
+ *   register.  Pixel coordinates don't need more than that.  The    *
+ *   running log-likelihoods of the track and global hypotheses      *
+ *   (see mht.H) are sums over many scans, and stay double either    *
+ *   way.                                                            *
+ *                                                                   *
+ *   The results of the two precisions aren't identical, so a        *
+ *   single-precision build should be checked against a normal one   *
+ *   on typical data before it's relied on (see compareTracks.py in  *
+ *   ../tracking).                                                   *
+ *                                                                   *
+ *********************************************************************/
+
+#ifndef PRECISION_H
+#define PRECISION_H
+
+#ifdef MHT_SINGLE_PRECISION
+typedef float MHT_REAL;
+#else
+typedef double MHT_REAL;
+#endif
+
+#endif
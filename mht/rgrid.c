@@ -0,0 +1,183 @@
+/*********************************************************************
+ * FILE: rgrid.C                                                     *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Routines for REPORT_GRID.  See rgrid.H for details.             *
+ *                                                                   *
+ *********************************************************************/
+
+#include <math.h>
+#include <stdlib.h>		// for qsort()
+
+#include "rgrid.h"
+
+/*-------------------------------------------------------------------*
+ | MAX_GRID_DIM -- limit on the number of cells along either axis
+ *-------------------------------------------------------------------*/
+
+static const int MAX_GRID_DIM = 1024;
+
+/*-------------------------------------------------------------------*
+ | REPORT_GRID::resize() -- make room for numPoints points
+ *-------------------------------------------------------------------*/
+
+void REPORT_GRID::resize( int numPoints )
+{
+
+
+    m_numPoints = numPoints;
+    m_numCellsX = m_numCellsY = 0;
+
+    /* NOTE: VECTOR_OF::resize() takes the highest index, not the
+       size, so these always have room for at least one entry */
+    m_x.resize( numPoints );
+    m_y.resize( numPoints );
+    m_cellPoints.resize( numPoints );
+    m_pointCell.resize( numPoints );
+}
+
+/*-------------------------------------------------------------------*
+ | REPORT_GRID::build() -- sort the points into cells
+ *-------------------------------------------------------------------*/
+
+void REPORT_GRID::build()
+{
+
+
+    double width, height;
+    int numCells;
+    int cell;
+    int i;
+
+    if( m_numPoints == 0 )
+    {
+        return;
+    }
+
+    /* find the bounding box of the points */
+    m_xMin = m_xMax = m_x[ 0 ];
+    m_yMin = m_yMax = m_y[ 0 ];
+    for( i = 1; i < m_numPoints; i++ )
+    {
+        if( m_x[ i ] < m_xMin ) m_xMin = m_x[ i ];
+        if( m_x[ i ] > m_xMax ) m_xMax = m_x[ i ];
+        if( m_y[ i ] < m_yMin ) m_yMin = m_y[ i ];
+        if( m_y[ i ] > m_yMax ) m_yMax = m_y[ i ];
+    }
+
+    /* choose square cells that hold about two points each */
+    width = m_xMax - m_xMin;
+    height = m_yMax - m_yMin;
+    m_cellSize = sqrt( 2. * width * height / m_numPoints );
+    if( m_cellSize < (width > height ? width : height) / MAX_GRID_DIM )
+    {
+        m_cellSize = (width > height ? width : height) / MAX_GRID_DIM;
+    }
+    if( m_cellSize <= 0. )
+    {
+        m_cellSize = 1.;
+    }
+
+    m_numCellsX = getCellX( m_xMax ) + 1;
+    m_numCellsY = getCellY( m_yMax ) + 1;
+    numCells = m_numCellsX * m_numCellsY;
+
+    /* count the points in each cell, then turn the counts into
+       starting positions in m_cellPoints */
+    m_cellStart.resize( numCells );
+    m_cellStart.clear();
+
+    for( i = 0; i < m_numPoints; i++ )
+    {
+        cell = getCellY( m_y[ i ] ) * m_numCellsX + getCellX( m_x[ i ] );
+        m_pointCell[ i ] = cell;
+        m_cellStart[ cell + 1 ]++;
+    }
+
+    for( cell = 0; cell < numCells; cell++ )
+    {
+        m_cellStart[ cell + 1 ] += m_cellStart[ cell ];
+    }
+
+    /* drop the points into their cells -- m_cellStart[ c ] is
+       advanced past each point as it's placed, and ends up at the
+       start of cell c + 1, so it's shifted back afterward */
+    for( i = 0; i < m_numPoints; i++ )
+    {
+        m_cellPoints[ m_cellStart[ m_pointCell[ i ] ]++ ] = i;
+    }
+
+    for( cell = numCells; cell > 0; cell-- )
+    {
+        m_cellStart[ cell ] = m_cellStart[ cell - 1 ];
+    }
+    m_cellStart[ 0 ] = 0;
+}
+
+/*-------------------------------------------------------------------*
+ | REPORT_GRID::query() -- find the points inside a box
+ *-------------------------------------------------------------------*/
+
+static int compareInts( const void *addr0, const void *addr1 )
+{
+    return *(const int *)addr0 - *(const int *)addr1;
+}
+
+int REPORT_GRID::query( double xMin, double yMin,
+                        double xMax, double yMax,
+                        VECTOR_OF< int > &result )
+{
+
+
+    int cx0, cy0, cx1, cy1;
+    int cx, cy;
+    int cell;
+    int numFound;
+    int isSorted;
+    int i, k;
+
+    if( m_numPoints == 0 ||
+        xMax < m_xMin || xMin > m_xMax ||
+        yMax < m_yMin || yMin > m_yMax )
+    {
+        return 0;
+    }
+
+    /* clip the box to the grid before converting to cell numbers,
+       so huge gates don't overflow the integer conversion */
+    cx0 = xMin > m_xMin ? getCellX( xMin ) : 0;
+    cy0 = yMin > m_yMin ? getCellY( yMin ) : 0;
+    cx1 = xMax < m_xMax ? getCellX( xMax ) : m_numCellsX - 1;
+    cy1 = yMax < m_yMax ? getCellY( yMax ) : m_numCellsY - 1;
+
+    numFound = 0;
+    isSorted = 1;
+    for( cy = cy0; cy <= cy1; cy++ )
+        for( cx = cx0; cx <= cx1; cx++ )
+        {
+            cell = cy * m_numCellsX + cx;
+            for( k = m_cellStart[ cell ]; k < m_cellStart[ cell + 1 ]; k++ )
+            {
+                i = m_cellPoints[ k ];
+                if( m_x[ i ] < xMin || m_x[ i ] > xMax ||
+                    m_y[ i ] < yMin || m_y[ i ] > yMax )
+                {
+                    continue;
+                }
+
+                if( numFound > 0 && result[ numFound - 1 ] > i )
+                {
+                    isSorted = 0;
+                }
+                result[ numFound++ ] = i;
+            }
+        }
+
+    if( ! isSorted )
+    {
+        qsort( &result[ 0 ], numFound, sizeof( int ), compareInts );
+    }
+
+    return numFound;
+}
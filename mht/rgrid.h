@@ -0,0 +1,136 @@
+/*********************************************************************
+ * FILE: rgrid.H                                                     *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Declaration of REPORT_GRID, a uniform grid used to find the     *
+ *   reports of one scan that fall inside an axis-aligned box.       *
+ *                                                                   *
+ *   MDL_MHT::measureAndValidate() uses a REPORT_GRID so that each   *
+ *   leaf of a track tree is only offered the reports that lie       *
+ *   inside its validation gate, instead of every report in the      *
+ *   scan (see mdlmht.H).                                            *
+ *                                                                   *
+ *   REPORT_GRID's have the following member functions:              *
+ *                                                                   *
+ *     REPORT_GRID()                                                 *
+ *       The constructor takes no arguments.                         *
+ *                                                                   *
+ *     void resize( int numPoints )                                  *
+ *       Prepare the grid for numPoints points, numbered from 0 to   *
+ *       numPoints - 1.  Any points from an earlier build are lost.  *
+ *                                                                   *
+ *     void setPoint( int i, double x, double y )                    *
+ *       Set the position of point i.                                *
+ *                                                                   *
+ *     void build()                                                  *
+ *       Sort the points into grid cells.  This must be called after *
+ *       all the points have been set, and before query().           *
+ *                                                                   *
+ *     int query( double xMin, double yMin,                          *
+ *                double xMax, double yMax,                          *
+ *                VECTOR_OF< int > &result )                         *
+ *       Find all the points with xMin <= x <= xMax and              *
+ *       yMin <= y <= yMax.  Their numbers are put into result in    *
+ *       increasing order, and the number of them is returned.      *
+ *       result must have room for getNumPoints() entries.           *
+ *                                                                   *
+ *     int getNumPoints()                                            *
+ *     double getX( int i )                                          *
+ *     double getY( int i )                                          *
+ *       Access the points.                                          *
+ *                                                                   *
+ * IMPLEMENTATION NOTES:                                             *
+ *                                                                   *
+ *   The grid covers the bounding box of the points, and is sized so *
+ *   that there are a couple of points per cell on average.  The     *
+ *   points in each cell are stored contiguously in m_cellPoints,    *
+ *   with m_cellStart[ c ] giving the first entry for cell c (a      *
+ *   counting sort), so building costs O(numPoints) and no memory is *
+ *   allocated once the grid has grown to its working size.          *
+ *                                                                   *
+ *   Within a cell, points are kept in increasing order, but a query *
+ *   visits several cells, so the result is sorted before it's       *
+ *   returned.  Callers rely on this to visit reports in the same    *
+ *   order as they appear on the report list.                        *
+ *                                                                   *
+ *********************************************************************/
+
+#ifndef RGRID_H
+#define RGRID_H
+
+#include "vector.h"
+
+class REPORT_GRID
+{
+private:
+
+    int m_numPoints;
+    VECTOR_OF< double > m_x;            // point positions
+    VECTOR_OF< double > m_y;
+
+    double m_xMin, m_yMin;              // bounding box of points
+    double m_xMax, m_yMax;
+    double m_cellSize;
+    int m_numCellsX, m_numCellsY;
+
+    VECTOR_OF< int > m_cellStart;       // index into m_cellPoints of
+                                        //   first point in each cell
+    VECTOR_OF< int > m_cellPoints;      // point numbers, by cell
+    VECTOR_OF< int > m_pointCell;       // cell of each point
+
+public:
+
+    REPORT_GRID():
+        m_numPoints( 0 ),
+        m_x(),
+        m_y(),
+        m_xMin( 0 ), m_yMin( 0 ),
+        m_xMax( 0 ), m_yMax( 0 ),
+        m_cellSize( 1 ),
+        m_numCellsX( 0 ), m_numCellsY( 0 ),
+        m_cellStart(),
+        m_cellPoints(),
+        m_pointCell()
+    {
+    }
+
+    void resize( int numPoints );
+
+    void setPoint( int i, double x, double y )
+    {
+        m_x[ i ] = x;
+        m_y[ i ] = y;
+    }
+
+    void build();
+    int query( double xMin, double yMin,
+               double xMax, double yMax,
+               VECTOR_OF< int > &result );
+
+    int getNumPoints()
+    {
+        return m_numPoints;
+    }
+    double getX( int i )
+    {
+        return m_x[ i ];
+    }
+    double getY( int i )
+    {
+        return m_y[ i ];
+    }
+
+private:
+
+    int getCellX( double x )
+    {
+        return (int)((x - m_xMin) / m_cellSize);
+    }
+    int getCellY( double y )
+    {
+        return (int)((y - m_yMin) / m_cellSize);
+    }
+};
+
+#endif
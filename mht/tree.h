@@ -968,18 +968,18 @@ class dummyTREEnode: public TREEnode
     friend class TREEbase;
     friend class PTR_INTO_TREEbase;
 
-protected:
+public:
 
-    virtual DLISTnode *XmakeCopy() const
+    dummyTREEnode(): TREEnode()
     {
-        return new dummyTREEnode( *this );
+        XmakeDummy();
     }
 
-public:
+protected:
 
-    virtual int isNode() const
+    virtual DLISTnode *XmakeCopy() const
     {
-        return 0;
+        return new dummyTREEnode( *this );
     }
 };
 
@@ -1131,6 +1131,8 @@ public:
  
 /*-------------------------------------------------------------------*
  | PTR_INTO_TREEbase -- base class for all PTR_INTO_xTREE's
+ |
+ | As with PTR_INTO_DLISTbase, the destructor isn't virtual.
  *-------------------------------------------------------------------*/
 
 class PTR_INTO_TREEbase
@@ -1181,7 +1183,7 @@ protected:
         ptr.checkNotRemoved();
     }
 
-    virtual ~PTR_INTO_TREEbase()
+    ~PTR_INTO_TREEbase()
     {
         m_dummy.Xreset();
     }
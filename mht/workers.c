@@ -0,0 +1,181 @@
+/*********************************************************************
+ * FILE: workers.C                                                   *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Routines for WORKER_POOL.  See workers.H for details.           *
+ *                                                                   *
+ *********************************************************************/
+
+#include <assert.h>
+
+#include "workers.h"
+
+/*-------------------------------------------------------------------*
+ | WORKER_POOL::WORKER_POOL() -- make a pool with no helpers
+ *-------------------------------------------------------------------*/
+
+WORKER_POOL::WORKER_POOL():
+    m_helpers(),
+    m_mutex(),
+    m_startCond(),
+    m_doneCond(),
+    m_job( 0 ),
+    m_numParts( 0 ),
+    m_numBusy( 0 ),
+    m_jobNumber( 0 ),
+    m_stopping( false )
+{
+}
+
+/*-------------------------------------------------------------------*
+ | WORKER_POOL::~WORKER_POOL() -- stop the helpers
+ *-------------------------------------------------------------------*/
+
+WORKER_POOL::~WORKER_POOL()
+{
+    stopHelpers();
+}
+
+/*-------------------------------------------------------------------*
+ | WORKER_POOL::setNumThreads() -- start or stop helpers to make up
+ |                                 numThreads threads
+ |
+ | Helper k has to do part k of every job, so when the number goes
+ | down they're all stopped, and the ones wanted started again.  The
+ | new helpers are told the number of the last job posted, so that
+ | one posted before they get going isn't missed.
+ *-------------------------------------------------------------------*/
+
+void WORKER_POOL::setNumThreads( int numThreads )
+{
+
+
+    int k;
+
+    if( numThreads < 1 )
+    {
+        numThreads = 1;
+    }
+
+    if( numThreads < getNumThreads() )
+    {
+        stopHelpers();
+    }
+
+    for( k = getNumThreads(); k < numThreads; k++ )
+    {
+        m_helpers.push_back( std::thread( &WORKER_POOL::help, this, k,
+                                          m_jobNumber ) );
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | WORKER_POOL::run() -- do the parts of a job, and wait for them
+ *-------------------------------------------------------------------*/
+
+void WORKER_POOL::run( const std::function< void( int ) > &job,
+                       int numParts )
+{
+
+
+#ifdef TSTBUG
+    assert( numParts <= getNumThreads() );
+#endif
+
+    if( numParts <= 1 )
+    {
+        if( numParts == 1 )
+        {
+            job( 0 );
+        }
+        return;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+
+        m_job = &job;
+        m_numParts = numParts;
+        m_numBusy = numParts - 1;
+        m_jobNumber++;
+    }
+    m_startCond.notify_all();
+
+    job( 0 );
+
+    std::unique_lock< std::mutex > lock( m_mutex );
+    while( m_numBusy > 0 )
+    {
+        m_doneCond.wait( lock );
+    }
+    m_job = 0;
+}
+
+/*-------------------------------------------------------------------*
+ | WORKER_POOL::stopHelpers() -- wake all the helpers up to quit,
+ |                               and join them
+ *-------------------------------------------------------------------*/
+
+void WORKER_POOL::stopHelpers()
+{
+
+
+    int k;
+
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+
+        m_stopping = true;
+    }
+    m_startCond.notify_all();
+
+    for( k = 0; k < (int)m_helpers.size(); k++ )
+    {
+        m_helpers[ k ].join();
+    }
+    m_helpers.clear();
+
+    m_stopping = false;
+}
+
+/*-------------------------------------------------------------------*
+ | WORKER_POOL::help() -- what helper thread number part does:
+ |                        sleep until a job after lastJobNumber is
+ |                        posted, do its part of it if there is
+ |                        one, and go back to sleep
+ *-------------------------------------------------------------------*/
+
+void WORKER_POOL::help( int part, long lastJobNumber )
+{
+
+
+    std::unique_lock< std::mutex > lock( m_mutex );
+
+    for( ;; )
+    {
+        while( ! m_stopping && m_jobNumber == lastJobNumber )
+        {
+            m_startCond.wait( lock );
+        }
+        if( m_stopping )
+        {
+            return;
+        }
+        lastJobNumber = m_jobNumber;
+
+        if( part < m_numParts )
+        {
+            const std::function< void( int ) > *job = m_job;
+
+            lock.unlock();
+            (*job)( part );
+            lock.lock();
+
+            if( --m_numBusy == 0 )
+            {
+                m_doneCond.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*********************************************************************
+ * FILE: workers.H                                                   *
+ *                                                                   *
+ * CONTENTS:                                                         *
+ *                                                                   *
+ *   Declaration of WORKER_POOL, a set of threads that are kept      *
+ *   waiting between jobs, so that work done every scan can be       *
+ *   shared out without starting and joining threads each time.      *
+ *                                                                   *
+ *   A job is split into numbered parts.  The thread that calls      *
+ *   run() does part 0 itself, and helper k does part k, so a pool   *
+ *   of N threads has N - 1 helpers.  run() returns when all the     *
+ *   parts are done; the parts must not depend on each other.        *
+ *                                                                   *
+ *   WORKER_POOL's have the following member functions:              *
+ *                                                                   *
+ *     WORKER_POOL()                                                 *
+ *       The constructor takes no arguments.  The pool starts out    *
+ *       with one thread (the caller's) and no helpers.              *
+ *                                                                   *
+ *     void setNumThreads( int numThreads )                          *
+ *     int getNumThreads()                                           *
+ *       Change or get the number of threads, counting the caller's. *
+ *       Helpers are started or stopped to make up the number.  This *
+ *       mustn't be called while run() is in progress.               *
+ *                                                                   *
+ *     void run( const std::function< void( int ) > &job,            *
+ *               int numParts )                                      *
+ *       Do job( 0 ) ... job( numParts - 1 ) at the same time, and   *
+ *       wait for all of them.  numParts may be at most              *
+ *       getNumThreads().  The helpers that aren't needed stay       *
+ *       asleep.                                                     *
+ *                                                                   *
+ *   The destructor stops the helpers.  A WORKER_POOL is run from    *
+ *   one thread at a time.                                           *
+ *                                                                   *
+ *********************************************************************/
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WORKER_POOL
+{
+private:
+
+    std::vector< std::thread > m_helpers;
+    std::mutex m_mutex;
+    std::condition_variable m_startCond; // a job has been posted, or
+                                         //   the helpers should stop
+    std::condition_variable m_doneCond;  // the last busy helper is done
+    const std::function< void( int ) > *m_job;
+    int m_numParts;
+    int m_numBusy;                       // helpers still on the job
+    long m_jobNumber;                    // counts the jobs posted
+    bool m_stopping;
+
+public:
+
+    WORKER_POOL();
+    ~WORKER_POOL();
+
+    void setNumThreads( int numThreads );
+    int getNumThreads()
+    {
+        return m_helpers.size() + 1;
+    }
+
+    void run( const std::function< void( int ) > &job, int numParts );
+
+private:
+
+    WORKER_POOL( const WORKER_POOL & );
+    WORKER_POOL &operator=( const WORKER_POOL & );
+
+    void stopHelpers();
+    void help( int part, long lastJobNumber );
+};
+
+#endif
@@ -0,0 +1,91 @@
+"""
+Compare the assignments in two OutDataFiles written by trackCorners, such
+as those of a normal build and a single-precision (MHT_SINGLE_PRECISION)
+build run on the same data.
+
+Each measured corner is identified by its frame and corner ID.  Within a
+track, a corner is assigned to follow the previous measured corner of the
+track (or to start it); otherwise it's a false alarm.  Every corner whose
+assignment differs between the two files is listed, by frame, along with
+the number of them.  The exit status is 1 if there are any, or, with
+--max-diverged, if more than that fraction of the corners differ.  The
+latter is how "make validate" (see makefile and README) accepts a
+single-precision build: a few near-tie decisions may go the other way,
+but no more than that.
+"""
+
+import sys
+
+
+def ReadAssignments(filename) :
+    """Map (frame, cornerID) to what the corner was assigned to: the
+    (frame, cornerID) of the corner it follows in its track, "start" for
+    the first corner of a track, or "false alarm"."""
+    lines = [line.split() for line in open(filename)
+             if line.strip() and not line.startswith('#')]
+
+    numTracks = int(lines[0][0])
+    numFalarms = int(lines[1][0])
+    pos = 2
+
+    assignments = {}
+    for track in range(numTracks) :
+        numElements = int(lines[pos][1])
+        pos += 1
+
+        prev = "start"
+        for fields in lines[pos:pos + numElements] :
+            # M rx ry sx sy logLikelihood time frameNo model... cornerID
+            if fields[0] == 'M' :
+                corner = (int(fields[7]), int(fields[-1]))
+                assignments[corner] = prev
+                prev = corner
+        pos += numElements
+
+    for fields in lines[pos:pos + numFalarms] :
+        # rX rY frameNo cornerID
+        assignments[(int(fields[2]), int(fields[3]))] = "false alarm"
+
+    return assignments
+
+
+def Describe(assignment) :
+    if isinstance(assignment, tuple) :
+        return "follows corner %d of frame %d" % (assignment[1], assignment[0])
+    return assignment
+
+
+if __name__ == '__main__' :
+    import argparse     # for command-line parsing
+
+
+    parser = argparse.ArgumentParser(
+        description="List the corners that two trackCorners runs assign "
+                    "differently")
+    parser.add_argument("fileA", help="OutDataFile of the first run")
+    parser.add_argument("fileB", help="OutDataFile of the second run")
+    parser.add_argument("--max-diverged", type=float, default=0.,
+                        help="fraction of the corners that may be "
+                             "assigned differently without failing "
+                             "(default 0)")
+
+    args = parser.parse_args()
+
+
+    assignA = ReadAssignments(args.fileA)
+    assignB = ReadAssignments(args.fileB)
+
+    corners = sorted(set(assignA) | set(assignB))
+    numDiverged = 0
+    for corner in corners :
+        a = assignA.get(corner, "missing")
+        b = assignB.get(corner, "missing")
+        if a != b :
+            print("frame %d, corner %d: %s in %s, %s in %s"
+                  % (corner[0], corner[1],
+                     Describe(a), args.fileA, Describe(b), args.fileB))
+            numDiverged += 1
+
+    print("%d of %d corners assigned differently" % (numDiverged, len(corners)))
+
+    sys.exit(1 if numDiverged > args.max_diverged * len(corners) else 0)
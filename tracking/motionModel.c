@@ -63,6 +63,7 @@
 #define CORR_COEFF
 
 #include <iostream>
+#include <vector>		// for std::vector<>
 
 double EPSILON = 0.00000000000001;
 
@@ -127,19 +128,153 @@ void CORNER_TRACK_MHT::verify( int trackId, double r_x, double r_y, double s_x,
  * them as reports
  *-------------------------------------------------------------------*/
 
+/*-------------------------------------------------------------------*
+ | MIN_REPORTS_PER_THREAD -- fewest reports worth handing a thread
+ |                           in measure()
+ *-------------------------------------------------------------------*/
+
+static const int MIN_REPORTS_PER_THREAD = 2048;
+
+static void computeTextureStats( CONSTPOS_REPORT **reports, int numReports )
+{
+    for (int i = 0; i < numReports; i++)
+    {
+        reports[i]->computeTextureStats();
+    }
+}
+
 void CORNER_TRACK_MHT::measure(const std::list<CORNER> &newReports)
 {
+    std::vector<CONSTPOS_REPORT *> reports;
+
     for (std::list<CORNER>::const_iterator cornerPtr = newReports.begin();
          cornerPtr != newReports.end();
          cornerPtr++)
     {
-        installReport(new CONSTPOS_REPORT(m_falarmLogLikelihood,
-                                          cornerPtr->x, cornerPtr->y,
-                                          cornerPtr->m_textureInfo,
-                                          cornerPtr->m_frameNo,cornerPtr->m_cornerID)
-                     );
+        reports.push_back(new CONSTPOS_REPORT(m_falarmLogLikelihood,
+                                              cornerPtr->x, cornerPtr->y,
+                                              cornerPtr->m_textureInfo,
+                                              cornerPtr->m_frameNo,cornerPtr->m_cornerID)
+                         );
+    }
+
+    /* the texture statistics of each report are independent of the
+       others, so big scans are shared out among the threads */
+    int numReports = reports.size();
+    int numThreads = getNumThreads();
+    if (numThreads > numReports / MIN_REPORTS_PER_THREAD)
+    {
+        numThreads = numReports / MIN_REPORTS_PER_THREAD;
+    }
+
+    if (numThreads <= 1)
+    {
+        computeTextureStats(reports.data(), numReports);
+    }
+    else
+    {
+        runInParallel([&reports, numReports, numThreads](int t)
+                      {
+                          int first = (int)((long)numReports * t / numThreads);
+                          int last = (int)((long)numReports * (t + 1) / numThreads);
+                          computeTextureStats(reports.data() + first,
+                                              last - first);
+                      },
+                      numThreads);
+    }
+
+    for (int i = 0; i < numReports; i++)
+    {
+        installReport(reports[i]);
+    }
+
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTPOS_REPORT::computeTextureStats() -- find the mean and sigma
+ |                                           of each window of the
+ |                                           texture patch, and its
+ |                                           pixels' deviations from
+ |                                           the mean
+ |
+ | Window w is centered at row w / NUM_SHIFTS + TEMPLATE_RADIUS,
+ | column w % NUM_SHIFTS + TEMPLATE_RADIUS of the patch.  Its pixels
+ | are numbered k = 0..NUM_PIXELS - 1 a row at a time, and
+ | m_windowDev is indexed by k first, for TextureCorr().  The sums
+ | are done in the same order that getCorr() used to do them for
+ | every state, so the correlations come out exactly the same.
+ *-------------------------------------------------------------------*/
+
+void CONSTPOS_REPORT::computeTextureStats()
+{
+    const int width = Texture_t::WIDTH;
+    const int r = TEMPLATE_RADIUS;
+    int xm,ym;
+    int index;
+    double mean, sigma;
+    int w, k;
+
+    for (w = 0; w < CORNER_WINDOWS::NUM_WINDOWS; w++)
+    {
+        ym = w / CORNER_WINDOWS::NUM_SHIFTS + r;
+        xm = w % CORNER_WINDOWS::NUM_SHIFTS + r;
+
+        mean=sigma=0.0;
+        for (int j=-r; j<=r ; j++)
+        {
+            int y = ym + j ;
+            for (int i=-r; i<=r; i++)
+            {
+                int x=xm + i ;
+                index = width * y + x;
+                mean += (double)(m_textureInfo[index]);
+                sigma += (double)(m_textureInfo[index])*( m_textureInfo[index]);
+            }
+        }
+        mean /= (double)CORNER_WINDOWS::NUM_PIXELS;
+        sigma /= (double)CORNER_WINDOWS::NUM_PIXELS;
+        sigma = sigma -mean*mean;
+        sigma = sqrt(sigma);
+
+        m_windowMean[w] = mean;
+        m_windowSigma[w] = sigma;
+
+        k = 0;
+        for (int j=-r; j<=r ; j++)
+        {
+            int y = ym + j ;
+            for (int i=-r; i<=r; i++)
+            {
+                int x=xm + i ;
+                index = width * y + x;
+                m_windowDev[k++][w] = (double)(m_textureInfo[index] - mean);
+            }
+        }
     }
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_STATE::getTextureDev() -- get the pixels of the centre
+ |                                    window of the texture, minus
+ |                                    their mean, a row at a time
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_STATE::getTextureDev( double *dev )
+{
+    const int width = Texture_t::WIDTH;
+    const int r = TEMPLATE_RADIUS;
+    int k = 0;
 
+    for (int j=-r; j<=r ; j++)
+    {
+        int y1 = TEXTURE_RADIUS + j;
+        for (int i=-r; i<=r; i++)
+        {
+            int x1 = TEXTURE_RADIUS + i;
+            int index1 = width * y1 + x1;
+            dev[k++] = (double)(m_prevTextureInfo[index1] - m_textureMean);
+        }
+    }
 }
 
 /*-------------------------------------------------------------------*
@@ -151,91 +286,884 @@ static const double LOG_NORMFACTOR =
 
 
 /*-------------------------------------------------------------------*
- | CORNER_TRACK_STATE::setup() -- compute parts of Kalman filter
- |                           calculation that are independent of
- |                           reports
+ | GATE_BOX_SLACK -- relative amount by which gate boxes are widened,
+ |                   so that rounding in the Mahalanobis distance
+ |                   can't validate a report outside the box
+ |
+ | In single precision, the rounding of a position is a few parts in
+ | 10^8 of the coordinate itself, which can be a lot more than that of
+ | the half-width of a gate, so the slack has to be bigger.
+ *-------------------------------------------------------------------*/
+
+#ifdef MHT_SINGLE_PRECISION
+static const double GATE_BOX_SLACK = 1e-3;
+#else
+static const double GATE_BOX_SLACK = 1e-6;
+#endif
+
+/*-------------------------------------------------------------------*
+ | SETUP_BATCH_SIZE -- number of states, or of filters, that are
+ |                     worked on together by prepareStates() and
+ |                     computeBatch()
+ *-------------------------------------------------------------------*/
+
+static const int SETUP_BATCH_SIZE = 32;
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_TRANSITION::CONSTVEL_TRANSITION() -- compute the state
+ |                                               transition and
+ |                                               process covariance
+ |                                               matrices for a time
+ |                                               step
  *-------------------------------------------------------------------*/
 
-void CONSTVEL_STATE::setup( double processVariance, const MATRIX &R )
+CONSTVEL_TRANSITION::CONSTVEL_TRANSITION( MHT_REAL ds,
+                                          double processVariance ):
+    m_ds( ds ),
+    m_F(),
+    m_Q()
 {
 
 
-    /* don't do this more than once */
-    if( m_hasBeenSetup )
+    MHT_REAL ds2 = ds * ds;
+    MHT_REAL ds3 = ds2 * ds;
+    MHT_REAL f[ 16 ] =
     {
-        return;
+        1.,    ds,    0.,    0.,
+        0.,    1.,    0.,    0.,
+        0.,    0.,    1.,    ds,
+        0.,    0.,    0.,    1.
+    };
+    MHT_REAL q[ 16 ] =
+    {
+        ds3/3, ds2/2,    0.,    0.,
+        ds2/2,    ds,    0.,    0.,
+           0.,    0., ds3/3, ds2/2,
+           0.,    0., ds2/2,    ds
+    };
+    int i;
+
+    for( i = 0; i < 16; i++ )
+    {
+        m_F.getData()[ i ] = f[ i ];
+        m_Q.getData()[ i ] = q[ i ] * processVariance;
     }
+}
 
-    m_ds = 1;
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER::CONSTVEL_FILTER() -- constructors
+ |
+ | The first leaves everything but the covariance and time step for
+ | computeBatch() to fill in.  The second computes the rest right
+ | away.
+ *-------------------------------------------------------------------*/
 
-    /* compute the state transition matrix and process covariance matrix
-       based on the above time step */
+CONSTVEL_FILTER::CONSTVEL_FILTER( const FIXED_SYMMETRIC< 4 > &P,
+                                  MHT_REAL ds,
+                                  unsigned long hash ):
+    m_P( P ),
+    m_ds( ds ),
+    m_hash( hash ),
+    m_refCount( 0 ),
+    m_nextInBucket( 0 ),
+    m_F(),
+    m_sChol(),
+    m_W(),
+    m_nextP()
+{
+}
 
-    double ds2 = m_ds * m_ds;
-    double ds3 = ds2 * m_ds;
+CONSTVEL_FILTER::CONSTVEL_FILTER( const FIXED_SYMMETRIC< 4 > &P,
+                                  unsigned long hash,
+                                  const CONSTVEL_TRANSITION &transition,
+                                  const FIXED_MATRIX< 2, 2 > &R,
+                                  double maxDistance ):
+    CONSTVEL_FILTER( P, transition.m_ds, hash )
+{
 
-    static MATRIX F( 4, 4 );
-    F.set(     1.,  m_ds,    0.,    0.,
-               0.,    1.,    0.,    0.,
-               0.,    0.,    1.,  m_ds,
-               0.,    0.,    0.,    1.    );
 
+    CONSTVEL_FILTER *filter = this;
 
-    static MATRIX Q( 4, 4 );
-    Q.set(  ds3/3, ds2/2,    0.,    0.,
-            ds2/2,  m_ds,    0.,    0.,
-            0.,    0., ds3/3, ds2/2,
-            0.,    0., ds2/2,  m_ds  );
-    Q = Q * processVariance;
+    computeBatch( &filter, 1, transition, R, maxDistance );
+}
 
-    static MATRIX H(2,4);
-    H.set(1., 0., 0., 0.,
-          0., 0., 1., 0.);
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER::computeBatch() -- compute the parts of the Kalman
+ |                                    filter calculation that depend
+ |                                    only on the covariance and time
+ |                                    step, for several filters
+ |
+ | The filters must all be for transition's time step.  Each matrix
+ | entry is kept in an array with an element per filter, so every
+ | step is a loop down those arrays.  The entries are worked out with
+ | the same operations, in the same order, as the FIXED_MATRIX
+ | expressions
+ |
+ |   P1 = F m_P F' + Q                   state prediction covariance
+ |   S = H P1 H' + R                     innovation covariance
+ |   L = FIXED_CHOLESKY< 2 >( S )
+ |   G = L.forwardSolve( H P1 )
+ |   m_W = L.backSolve( G ).trans()      filter gain
+ |   m_nextP = P1 - G' G                 updated state covariance
+ |
+ | (multiplications by the zeros and ones in F and H included), so a
+ | filter comes out the same however it's batched.
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_FILTER::computeBatch( CONSTVEL_FILTER **filters,
+                                    int numFilters,
+                                    const CONSTVEL_TRANSITION &transition,
+                                    const FIXED_MATRIX< 2, 2 > &R,
+                                    double maxDistance )
+{
+
+
+    typedef FIXED_SYMMETRIC< 4 > SYM4;
+    typedef FIXED_SYMMETRIC< 2 > SYM2;
+    static const MHT_REAL H[ 2 ][ 4 ] =
+    {
+        { 1., 0., 0., 0. },
+        { 0., 0., 1., 0. }
+    };
+    const int B = SETUP_BATCH_SIZE;
+    const MHT_REAL *F = transition.m_F.getData();
+    const MHT_REAL *Q = transition.m_Q.getData();
+    MHT_REAL P[ SYM4::SIZE ][ B ];       // covariances
+    MHT_REAL FP[ 16 ][ B ];              // F P
+    MHT_REAL P1[ SYM4::SIZE ][ B ];      // state prediction covariances
+    MHT_REAL HP1[ 8 ][ B ];              // H P1
+    MHT_REAL S[ SYM2::SIZE ][ B ];       // innovation covariances
+    MHT_REAL L[ SYM2::SIZE ][ B ];       // their Cholesky factors
+    MHT_REAL G[ 8 ][ B ];                // L^-1 H P1
+    MHT_REAL W[ 8 ][ B ];                // filter gains
+    MHT_REAL nextP[ SYM4::SIZE ][ B ];   // updated covariances
+    MHT_REAL sum[ B ];
+    CONSTVEL_FILTER *filter;
+    int first, n;
+    int row, col, i, j;
+
+    for( first = 0; first < numFilters; first += B )
+    {
+        n = numFilters - first < B ? numFilters - first : B;
+
+        for( j = 0; j < n; j++ )
+        {
+            filter = filters[ first + j ];
+#ifdef TSTBUG
+            assert( filter->m_ds == transition.m_ds );
+#endif
+            for( i = 0; i < SYM4::SIZE; i++ )
+            {
+                P[ i ][ j ] = filter->m_P.getData()[ i ];
+            }
+        }
+
+        /* P1 = F P F' + Q, of which only the lower triangle is kept */
+        for( row = 0; row < 4; row++ )
+            for( col = 0; col < 4; col++ )
+            {
+                for( j = 0; j < n; j++ )
+                {
+                    sum[ j ] = 0.;
+                }
+                for( i = 0; i < 4; i++ )
+                    for( j = 0; j < n; j++ )
+                    {
+                        sum[ j ] += F[ row * 4 + i ] *
+                                    P[ SYM4::index( i, col ) ][ j ];
+                    }
+                for( j = 0; j < n; j++ )
+                {
+                    FP[ row * 4 + col ][ j ] = sum[ j ];
+                }
+            }
+
+        for( row = 0; row < 4; row++ )
+            for( col = 0; col <= row; col++ )
+            {
+                for( j = 0; j < n; j++ )
+                {
+                    sum[ j ] = 0.;
+                }
+                for( i = 0; i < 4; i++ )
+                    for( j = 0; j < n; j++ )
+                    {
+                        sum[ j ] += FP[ row * 4 + i ][ j ] *
+                                    F[ col * 4 + i ];
+                    }
+                for( j = 0; j < n; j++ )
+                {
+                    P1[ SYM4::index( row, col ) ][ j ] =
+                        sum[ j ] + Q[ row * 4 + col ];
+                }
+            }
+
+        /* S = H P1 H' + R */
+        for( row = 0; row < 2; row++ )
+            for( col = 0; col < 4; col++ )
+            {
+                for( j = 0; j < n; j++ )
+                {
+                    sum[ j ] = 0.;
+                }
+                for( i = 0; i < 4; i++ )
+                    for( j = 0; j < n; j++ )
+                    {
+                        sum[ j ] += H[ row ][ i ] *
+                                    P1[ SYM4::index( i, col ) ][ j ];
+                    }
+                for( j = 0; j < n; j++ )
+                {
+                    HP1[ row * 4 + col ][ j ] = sum[ j ];
+                }
+            }
+
+        for( row = 0; row < 2; row++ )
+            for( col = 0; col <= row; col++ )
+            {
+                for( j = 0; j < n; j++ )
+                {
+                    sum[ j ] = 0.;
+                }
+                for( i = 0; i < 4; i++ )
+                    for( j = 0; j < n; j++ )
+                    {
+                        sum[ j ] += HP1[ row * 4 + i ][ j ] * H[ col ][ i ];
+                    }
+                for( j = 0; j < n; j++ )
+                {
+                    S[ SYM2::index( row, col ) ][ j ] =
+                        sum[ j ] + R( row, col );
+                }
+            }
+
+        /* S = L L' (as in FIXED_CHOLESKY< 2 >) */
+        for( j = 0; j < n; j++ )
+        {
+#ifdef TSTBUG
+            assert( S[ 0 ][ j ] > 0 );
+#endif
+
+            L[ 0 ][ j ] = sqrt( S[ 0 ][ j ] );
+            L[ 1 ][ j ] = S[ 1 ][ j ] / L[ 0 ][ j ];
+            L[ 2 ][ j ] = sqrt( S[ 2 ][ j ] - L[ 1 ][ j ] * L[ 1 ][ j ] );
+        }
+
+        /* G = L^-1 H P1, and W' = L'^-1 G, so that W = P1 H' S^-1 and
+           W S W' = G' G */
+        for( col = 0; col < 4; col++ )
+            for( j = 0; j < n; j++ )
+            {
+                G[ col ][ j ] = HP1[ col ][ j ] / L[ 0 ][ j ];
+                G[ 4 + col ][ j ] = (HP1[ 4 + col ][ j ] -
+                                     L[ 1 ][ j ] * G[ col ][ j ]) /
+                                    L[ 2 ][ j ];
+
+                W[ col * 2 + 1 ][ j ] = G[ 4 + col ][ j ] / L[ 2 ][ j ];
+                W[ col * 2 ][ j ] = (G[ col ][ j ] -
+                                     L[ 1 ][ j ] * W[ col * 2 + 1 ][ j ]) /
+                                    L[ 0 ][ j ];
+            }
+
+        for( row = 0; row < 4; row++ )
+            for( col = 0; col <= row; col++ )
+            {
+                for( j = 0; j < n; j++ )
+                {
+                    sum[ j ] = 0.;
+                }
+                for( i = 0; i < 2; i++ )
+                    for( j = 0; j < n; j++ )
+                    {
+                        sum[ j ] += G[ i * 4 + row ][ j ] *
+                                    G[ i * 4 + col ][ j ];
+                    }
+                for( j = 0; j < n; j++ )
+                {
+                    nextP[ SYM4::index( row, col ) ][ j ] =
+                        P1[ SYM4::index( row, col ) ][ j ] - sum[ j ];
+                }
+            }
+
+        /* fill in the filters */
+        for( j = 0; j < n; j++ )
+        {
+            filter = filters[ first + j ];
+
+            filter->m_F = transition.m_F;
+            for( i = 0; i < SYM2::SIZE; i++ )
+            {
+                filter->m_sChol.getData()[ i ] = L[ i ][ j ];
+            }
+            for( i = 0; i < 8; i++ )
+            {
+                filter->m_W.getData()[ i ] = W[ i ][ j ];
+            }
+            for( i = 0; i < SYM4::SIZE; i++ )
+            {
+                filter->m_nextP.getData()[ i ] = nextP[ i ][ j ];
+            }
+
+            filter->m_logLikelihoodCoef =
+                -(LOG_NORMFACTOR + filter->m_sChol.logDet() / 2);
+
+            /* v' S^-1 v <= maxDistance implies
+               |v_x| <= sqrt( maxDistance * S_xx ) (and likewise for
+               y), so a box this size around the predicted position
+               holds the whole gate */
+            filter->m_gateHalfWidth = sqrt( maxDistance * S[ 0 ][ j ] ) *
+                                      (1. + GATE_BOX_SLACK);
+            filter->m_gateHalfHeight = sqrt( maxDistance * S[ 2 ][ j ] ) *
+                                       (1. + GATE_BOX_SLACK);
+
+#ifdef DEBUG1
+            printf("\nF:\n");
+            filter->m_F.print();
+            printf("\nm_P:\n");
+            filter->m_P.print();
+            printf("\nS_chol:\n");
+            filter->m_sChol.print();
+            printf("\nm_nextP:\n");
+            filter->m_nextP.print();
+            printf(" m_logLikelihoodCoef= %lf\n", filter->m_logLikelihoodCoef);
+#endif
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::~CONSTVEL_FILTER_CACHE() -- destructor
+ *-------------------------------------------------------------------*/
+
+CONSTVEL_FILTER_CACHE::~CONSTVEL_FILTER_CACHE()
+{
+
+
+    CONSTVEL_FILTER *filter;
+    int i;
+
+    for( i = 0; i < m_numBuckets; i++ )
+        while( (filter = m_buckets[ i ]) != 0 )
+        {
+            m_buckets[ i ] = filter->m_nextInBucket;
+            delete filter;
+        }
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::hashKey() -- hash a covariance and time step
+ *-------------------------------------------------------------------*/
+
+unsigned long CONSTVEL_FILTER_CACHE::hashKey( const FIXED_SYMMETRIC< 4 > &P,
+                                              MHT_REAL ds )
+{
+
+
+    const unsigned char *bytes;
+    unsigned long hash;
+    int i;
+
+    /* FNV-1a, over the bits of the covariance and time step */
+    hash = 2166136261UL;
+    bytes = (const unsigned char *)P.getData();
+    for( i = 0; i < FIXED_SYMMETRIC< 4 >::SIZE * (int)sizeof( MHT_REAL ); i++ )
+    {
+        hash = (hash ^ bytes[ i ]) * 16777619UL;
+    }
+    bytes = (const unsigned char *)&ds;
+    for( i = 0; i < (int)sizeof( MHT_REAL ); i++ )
+    {
+        hash = (hash ^ bytes[ i ]) * 16777619UL;
+    }
+
+    return hash;
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::get() -- get the filter for a covariance
+ |                                 and transition's time step
+ |
+ | The new filter is made without holding the lock, since that's the
+ | expensive part.  If another thread makes the same one meanwhile,
+ | ours is thrown away (see add()).
+ *-------------------------------------------------------------------*/
+
+CONSTVEL_FILTER *CONSTVEL_FILTER_CACHE::get( const FIXED_SYMMETRIC< 4 > &P,
+                                             const CONSTVEL_TRANSITION &transition,
+                                             const FIXED_MATRIX< 2, 2 > &R,
+                                             double maxDistance )
+{
+
+
+    CONSTVEL_FILTER *filter;
+    unsigned long hash;
+
+    hash = hashKey( P, transition.m_ds );
+
+    filter = lookup( P, transition.m_ds, hash );
+    if( filter != 0 )
+    {
+        return filter;
+    }
+
+    return add( new CONSTVEL_FILTER( P, hash, transition, R, maxDistance ),
+                1 );
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::lookup() -- get the filter for a covariance
+ |                                    and time step, if there is one
+ |
+ | hash is hashKey( P, ds ).  Returns 0 if the filter hasn't been
+ | made yet.
+ *-------------------------------------------------------------------*/
+
+CONSTVEL_FILTER *CONSTVEL_FILTER_CACHE::lookup( const FIXED_SYMMETRIC< 4 > &P,
+                                                MHT_REAL ds,
+                                                unsigned long hash )
+{
+
+
+    CONSTVEL_FILTER *filter;
+
+    m_mutex.lock();
+    filter = find( P, ds, hash );
+    if( filter != 0 )
+    {
+        filter->m_refCount++;
+    }
+    m_mutex.unlock();
+
+    return filter;
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::add() -- put a newly made filter into the
+ |                                 cache, for numRefs states
+ |
+ | If another thread has added the same one meanwhile, newFilter is
+ | deleted (the two are identical anyway), and the one that's already
+ | there is returned instead.
+ *-------------------------------------------------------------------*/
+
+CONSTVEL_FILTER *CONSTVEL_FILTER_CACHE::add( CONSTVEL_FILTER *newFilter,
+                                             int numRefs )
+{
+
+
+    CONSTVEL_FILTER *filter;
+    int bucket;
+
+    m_mutex.lock();
+    filter = find( newFilter->m_P, newFilter->m_ds, newFilter->m_hash );
+    if( filter == 0 )
+    {
+        filter = newFilter;
+        newFilter = 0;
+
+        if( m_numFilters >= 2 * m_numBuckets )
+        {
+            rehash( m_numBuckets == 0 ? 64 : 4 * m_numBuckets );
+        }
+
+        bucket = (int)(filter->m_hash % m_numBuckets);
+        filter->m_nextInBucket = m_buckets[ bucket ];
+        m_buckets[ bucket ] = filter;
+        m_numFilters++;
+    }
+    filter->m_refCount += numRefs;
+    m_mutex.unlock();
+
+    delete newFilter;
+
+    return filter;
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::hold() -- note that another state is using
+ |                                  a filter from get()
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_FILTER_CACHE::hold( CONSTVEL_FILTER *filter )
+{
+
+
+    m_mutex.lock();
+    filter->m_refCount++;
+    m_mutex.unlock();
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::release() -- note that a state is done with
+ |                                     a filter
+ |
+ | Returns 1 if that was the last state using it, so that it was
+ | deleted.
+ *-------------------------------------------------------------------*/
+
+int CONSTVEL_FILTER_CACHE::release( CONSTVEL_FILTER *filter )
+{
+
+
+    CONSTVEL_FILTER **link;
+    int wasDeleted = 0;
+
+    m_mutex.lock();
+
+    if( --filter->m_refCount == 0 )
+    {
+        link = &m_buckets[ (int)(filter->m_hash % m_numBuckets) ];
+        while( *link != filter )
+        {
+            link = &(*link)->m_nextInBucket;
+        }
+        *link = filter->m_nextInBucket;
+        m_numFilters--;
+
+        delete filter;
+        wasDeleted = 1;
+    }
+
+    m_mutex.unlock();
+
+    return wasDeleted;
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::find() -- look for a filter (the lock must
+ |                                  be held)
+ *-------------------------------------------------------------------*/
+
+CONSTVEL_FILTER *CONSTVEL_FILTER_CACHE::find( const FIXED_SYMMETRIC< 4 > &P,
+                                              MHT_REAL ds,
+                                              unsigned long hash )
+{
+
+
+    CONSTVEL_FILTER *filter;
+
+    if( m_numBuckets == 0 )
+    {
+        return 0;
+    }
+
+    for( filter = m_buckets[ (int)(hash % m_numBuckets) ];
+         filter != 0;
+         filter = filter->m_nextInBucket )
+    {
+        if( filter->matches( P, ds, hash ) )
+        {
+            return filter;
+        }
+    }
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_FILTER_CACHE::rehash() -- change the number of buckets
+ |                                    (the lock must be held)
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_FILTER_CACHE::rehash( int numBuckets )
+{
+
+
+    VECTOR_OF< CONSTVEL_FILTER * > buckets( numBuckets - 1 );
+    CONSTVEL_FILTER *filter;
+    int bucket;
+    int i;
+
+    buckets.clear();
+
+    for( i = 0; i < m_numBuckets; i++ )
+        while( (filter = m_buckets[ i ]) != 0 )
+        {
+            m_buckets[ i ] = filter->m_nextInBucket;
+            bucket = (int)(filter->m_hash % numBuckets);
+            filter->m_nextInBucket = buckets[ bucket ];
+            buckets[ bucket ] = filter;
+        }
+
+    m_buckets.resize( numBuckets - 1 );
+    for( i = 0; i < numBuckets; i++ )
+    {
+        m_buckets[ i ] = buckets[ i ];
+    }
+    m_numBuckets = numBuckets;
+}
+
+/*-------------------------------------------------------------------*
+ | relativeDifference() -- largest difference between the entries of
+ |                         two covariances, relative to the largest
+ |                         entry of the second
+ *-------------------------------------------------------------------*/
+
+static double relativeDifference( const FIXED_SYMMETRIC< 4 > &P,
+                                  const FIXED_SYMMETRIC< 4 > &ref )
+{
+
+
+    const MHT_REAL *p = P.getData();
+    const MHT_REAL *r = ref.getData();
+    double maxDiff = 0;
+    double maxRef = 0;
+    int i;
+
+    for( i = 0; i < FIXED_SYMMETRIC< 4 >::SIZE; i++ )
+    {
+        if( fabs( p[ i ] - r[ i ] ) > maxDiff )
+        {
+            maxDiff = fabs( p[ i ] - r[ i ] );
+        }
+        if( fabs( r[ i ] ) > maxRef )
+        {
+            maxRef = fabs( r[ i ] );
+        }
+    }
+
+    /* written so that NaNs give a NaN, which is never within
+       tolerance */
+    return maxDiff == 0 ? 0 : maxDiff / maxRef;
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::prepareStates() -- compute the parts of the Kalman
+ |                                  filter calculation that are
+ |                                  independent of reports, for a
+ |                                  batch of states
+ |
+ | States that have already been set up are skipped.  The rest are
+ | done in blocks of SETUP_BATCH_SIZE: each state's filter is found
+ | (the converged one, or one from the cache), the filters that
+ | weren't found are made together by computeBatch(), and then the
+ | predictions and gate boxes are worked out, with the estimates
+ | gathered into an array per entry.
+ |
+ | CONSTVEL_STATE::setup() calls this for single states, possibly
+ | from several threads at once, so everything is kept on the stack.
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_MDL::prepareStates( MDL_STATE **mdlStates, int numStates )
+{
+
+
+    const int B = SETUP_BATCH_SIZE;
+    CONSTVEL_STATE *states[ B ];         // states in this block
+    int newFilterNum[ B ];               // which of newFilters each
+                                         //   state uses (-1 if none)
+    CONSTVEL_FILTER *newFilters[ B ];    // filters that weren't found
+    int numNewRefs[ B ];                 //   and the number of states
+                                         //   using each
+    MHT_REAL x[ 4 ][ B ];                // state estimates
+    MHT_REAL F[ 16 ][ B ];               // state transition matrices
+    MHT_REAL x1[ 4 ][ B ];               // predictions
+    MHT_REAL halfWidth[ B ], halfHeight[ B ];
+    MHT_REAL reach[ B ];
+    MHT_REAL xMin[ B ], xMax[ B ], yMin[ B ], yMax[ B ];
+    CONSTVEL_STATE *state;
+    CONSTVEL_FILTER *filter;
+    unsigned long hash;
+    int numInBlock;
+    int numNew;
+    int next;
+    int i, j, k;
+
+    next = 0;
+    while( next < numStates )
+    {
+        /* find the filters */
+        numInBlock = 0;
+        numNew = 0;
+        for( ; next < numStates && numInBlock < B; next++ )
+        {
+            state = (CONSTVEL_STATE *)mdlStates[ next ];
+            if( state->m_hasBeenSetup )
+            {
+                continue;
+            }
 
+            state->m_ds = m_transition->m_ds;
+            newFilterNum[ numInBlock ] = -1;
+
+            /* in steady-state mode, a state close enough to
+               convergence uses the converged filter */
+            if( m_steadyFilter != 0 && state->m_ds == m_steadyFilter->m_ds )
+            {
+                double deviation = relativeDifference( state->m_P,
+                                                       m_steadyFilter->m_P );
 
-    /* fill in the rest of the variables */
+                if( deviation <= m_steadyStateTolerance )
+                {
+                    state->m_filter = m_steadyFilter;
+                    m_filterCache.hold( state->m_filter );
+                    state->m_steadyStateDeviation = deviation;
+
+                    m_numSteadyStates++;
+                    double maxDeviation = m_maxSteadyStateDeviation;
+                    while( deviation > maxDeviation &&
+                           ! m_maxSteadyStateDeviation.compare_exchange_weak(
+                               maxDeviation, deviation ) )
+                    {
+                    }
+                }
+            }
 
-    MATRIX P1 = F * m_P * F.trans() + Q; // state prediction covariance
+            /* otherwise, the covariance-dependent parts are shared
+               with every other state that has the same covariance --
+               including ones earlier in this block, whose filters
+               haven't been made yet */
+            if( state->m_filter == 0 )
+            {
+                hash = CONSTVEL_FILTER_CACHE::hashKey( state->m_P,
+                                                       state->m_ds );
+                state->m_filter = m_filterCache.lookup( state->m_P,
+                                                        state->m_ds, hash );
+                if( state->m_filter == 0 )
+                {
+                    for( k = 0; k < numNew; k++ )
+                        if( newFilters[ k ]->matches( state->m_P,
+                                                      state->m_ds, hash ) )
+                        {
+                            break;
+                        }
+
+                    if( k == numNew )
+                    {
+                        newFilters[ numNew ] =
+                            new CONSTVEL_FILTER( state->m_P, state->m_ds,
+                                                 hash );
+                        numNewRefs[ numNew ] = 0;
+                        numNew++;
+                    }
+
+                    newFilterNum[ numInBlock ] = k;
+                    numNewRefs[ k ]++;
+                }
+                m_numExactStates++;
+            }
 
-    MATRIX S = H * P1 * H.trans() + R;  // innovation covariance
+            states[ numInBlock++ ] = state;
+        }
 
-    m_logLikelihoodCoef = -(LOG_NORMFACTOR + log( S.det() ) / 2);
+        /* make the missing filters */
+        if( numNew > 0 )
+        {
+            CONSTVEL_FILTER::computeBatch( newFilters, numNew,
+                                           *m_transition, m_R,
+                                           m_maxDistance );
+            for( k = 0; k < numNew; k++ )
+            {
+                newFilters[ k ] = m_filterCache.add( newFilters[ k ],
+                                                     numNewRefs[ k ] );
+            }
+            for( j = 0; j < numInBlock; j++ )
+                if( newFilterNum[ j ] >= 0 )
+                {
+                    states[ j ]->m_filter = newFilters[ newFilterNum[ j ] ];
+                }
+        }
 
-    m_Sinv = new MATRIX( S.inv() );
-//  printf("Sinv:\n"); m_Sinv->print();
+        /* x1 = F x, summed as in FIXED_PRODUCT */
+        for( j = 0; j < numInBlock; j++ )
+        {
+            state = states[ j ];
+            filter = state->m_filter;
+            for( i = 0; i < 4; i++ )
+            {
+                x[ i ][ j ] = state->m_x( i );
+            }
+            for( i = 0; i < 16; i++ )
+            {
+                F[ i ][ j ] = filter->m_F.getData()[ i ];
+            }
+            halfWidth[ j ] = filter->m_gateHalfWidth;
+            halfHeight[ j ] = filter->m_gateHalfHeight;
+            reach[ j ] = m_maxSpeed * state->m_ds;
+        }
 
-    m_W = new MATRIX( P1 * H.trans() * *m_Sinv );
+        for( i = 0; i < 4; i++ )
+        {
+            for( j = 0; j < numInBlock; j++ )
+            {
+                x1[ i ][ j ] = 0.;
+            }
+            for( k = 0; k < 4; k++ )
+                for( j = 0; j < numInBlock; j++ )
+                {
+                    x1[ i ][ j ] += F[ i * 4 + k ][ j ] * x[ k ][ j ];
+                }
+        }
 
-    MATRIX tmp(4,4);
-    tmp =  *m_W * S * m_W->trans();
+        for( j = 0; j < numInBlock; j++ )
+        {
+            xMin[ j ] = x1[ 0 ][ j ] - halfWidth[ j ];
+            xMax[ j ] = x1[ 0 ][ j ] + halfWidth[ j ];
+            yMin[ j ] = x1[ 2 ][ j ] - halfHeight[ j ];
+            yMax[ j ] = x1[ 2 ][ j ] + halfHeight[ j ];
+        }
 
-    MATRIX tmp1(4,4);
-    tmp1 = P1-tmp;
+        /* no report further from the current position than the
+           target could have travelled is plausible */
+        if( m_maxSpeed > 0 )
+        {
+            for( j = 0; j < numInBlock; j++ )
+            {
+                if( xMin[ j ] < x[ 0 ][ j ] - reach[ j ] )
+                {
+                    xMin[ j ] = x[ 0 ][ j ] - reach[ j ];
+                }
+                if( xMax[ j ] > x[ 0 ][ j ] + reach[ j ] )
+                {
+                    xMax[ j ] = x[ 0 ][ j ] + reach[ j ];
+                }
+                if( yMin[ j ] < x[ 2 ][ j ] - reach[ j ] )
+                {
+                    yMin[ j ] = x[ 2 ][ j ] - reach[ j ];
+                }
+                if( yMax[ j ] > x[ 2 ][ j ] + reach[ j ] )
+                {
+                    yMax[ j ] = x[ 2 ][ j ] + reach[ j ];
+                }
+            }
+        }
 
-    m_nextP = new MATRIX( tmp1 );
-    m_x1 = new MATRIX( F * m_x );
+        for( j = 0; j < numInBlock; j++ )
+        {
+            state = states[ j ];
+            for( i = 0; i < 4; i++ )
+            {
+                state->m_x1( i ) = x1[ i ][ j ];
+            }
+            state->m_gateXMin = xMin[ j ];
+            state->m_gateXMax = xMax[ j ];
+            state->m_gateYMin = yMin[ j ];
+            state->m_gateYMax = yMax[ j ];
 
-    m_hasBeenSetup = 1;
+            state->m_hasBeenSetup = 1;
 
 #ifdef DEBUG1
-    printf("\nF:\n");
-    F.print();
-    printf("\nm_P:\n");
-    m_P.print();
-    printf("\nQ=\n");
-    Q.print();
-    printf("\nState Pred Cov(P1=F*m_P*F.trans +Q):\n");
-    P1.print();
-    printf("\nInnov Cov(S=H*P1*H.trans):\n");
-    S.print();
-    printf("\nS_inv:\n");
-    m_Sinv->print();
-    printf("\nPrevious State:\n");
-    m_x.print();
-    printf("LOG_NORMFACTOR =%lf log( S.det() ) / 2)=%lf\n",LOG_NORMFACTOR, log( S.det() ) / 2);
-    printf(" m_logLikelihoodCoef= %lf\n", m_logLikelihoodCoef);
+            printf("\nPrevious State:\n");
+            state->m_x.print();
 #endif
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::releaseState() -- drop a grown state's hold on its
+ |                                 filter
+ |
+ | The filter is deleted if no other state is using it.  The rest of
+ | what setup() works out is kept in the state itself, so it goes
+ | when the state does.
+ *-------------------------------------------------------------------*/
+
+size_t CONSTVEL_MDL::releaseState( MDL_STATE *mdlState )
+{
+
 
+    return ((CONSTVEL_STATE *)mdlState)->cleanup();
 }
 
 /*--------------------------------------------*
@@ -258,14 +1186,123 @@ double CONSTVEL_MDL::getStateY(MDL_STATE *s)
 }
 
 
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::getGateBox() -- get the box that contains every
+ |                               report that might be validated in
+ |                               getNextState()
+ |
+ | This is the box computed by prepareStates().  It's only
+ | given once the state has been set up, because getNewState() may
+ | change the velocity of a state before that, which would move the
+ | prediction.
+ *-------------------------------------------------------------------*/
+
+int CONSTVEL_MDL::getGateBox( MDL_STATE *mdlState,
+                              double *xMin, double *yMin,
+                              double *xMax, double *yMax )
+{
+    CONSTVEL_STATE *state = (CONSTVEL_STATE *)mdlState;
+
+    if( ! state->m_hasBeenSetup )
+    {
+        return 0;
+    }
+
+    *xMin = state->m_gateXMin;
+    *xMax = state->m_gateXMax;
+    *yMin = state->m_gateYMin;
+    *yMax = state->m_gateYMax;
+
+    /* a NaN anywhere means the Mahalanobis test can't be trusted to
+       reject anything, so every report has to be tried */
+    return isfinite( *xMin ) && isfinite( *xMax ) &&
+           isfinite( *yMin ) && isfinite( *yMax );
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::gateReports() -- apply the Mahalanobis and texture
+ |                                tests in getNextState() to a batch
+ |                                of reports
+ |
+ | GateReports2D() gets exactly the distances that getNextState()
+ | gets, and TextureCorrBatch() exactly the correlations that
+ | getCorr() gets, so the reports rejected here are the ones
+ | getNextState() would have rejected.
+ *-------------------------------------------------------------------*/
+
+int CONSTVEL_MDL::gateReports( MDL_STATE *mdlState, int numReports,
+                               MDL_REPORT **reports,
+                               const MHT_REAL *x, const MHT_REAL *y,
+                               int *passed, MHT_REAL *distance )
+{
+    CONSTVEL_STATE *state = (CONSTVEL_STATE *)mdlState;
+    int numPassed;
+
+    if( ! state->m_hasBeenSetup )
+    {
+        return -1;
+    }
+
+    numPassed = GateReports2D( state->getX1(), state->getY1(),
+                               state->getSChol().getData(),
+                               m_maxDistance,
+                               x, y, numReports,
+                               passed, distance );
+
+#ifdef CORR_COEFF
+    if( numPassed > 0 )
+    {
+        static thread_local VECTOR_OF< const double * > windowDevs;
+        static thread_local VECTOR_OF< const double * > windowSigmas;
+        static thread_local VECTOR_OF< double > maxCorr;
+        CONSTPOS_REPORT *report;
+        double stateDev[ CORNER_WINDOWS::NUM_PIXELS ];
+        int numKept;
+        int i;
+
+        windowDevs.resize( numPassed );
+        windowSigmas.resize( numPassed );
+        maxCorr.resize( numPassed );
+
+        for( i = 0; i < numPassed; i++ )
+        {
+            report = (CONSTPOS_REPORT *)reports[ passed[ i ] ];
+            windowDevs[ i ] = &report->m_windowDev[ 0 ][ 0 ];
+            windowSigmas[ i ] = report->m_windowSigma;
+        }
+
+        state->getTextureDev( stateDev );
+        int inRange =
+            TextureCorrBatch< TEMPLATE_RADIUS, TEXTURE_RADIUS >(
+                stateDev, state->m_textureSigma,
+                &windowDevs[ 0 ], &windowSigmas[ 0 ],
+                numPassed, &maxCorr[ 0 ] );
+        assert( inRange );
+
+        numKept = 0;
+        for( i = 0; i < numPassed; i++ )
+        {
+            if( maxCorr[ i ] > m_intensityThreshold )
+            {
+                passed[ numKept ] = passed[ i ];
+                distance[ numKept ] = distance[ i ];
+                numKept++;
+            }
+        }
+        numPassed = numKept;
+    }
+#endif
+
+    return numPassed;
+}
+
 double CONSTVEL_MDL::getEndLogLikelihood( MDL_STATE *s )
 {
     CONSTVEL_STATE *cs = (CONSTVEL_STATE*)s;
     int m = cs->m_numSkipped;
     double endProb = 1.0 - exp( -m / m_lambda_x);
     endProb += (endProb == 0.0) ? EPSILON : 0.0;
-    m_endLogLikelihood = log( endProb);
-    return m_endLogLikelihood;
+    return log( endProb);
 }
 double CONSTVEL_MDL::getContinueLogLikelihood( MDL_STATE *s )
 {
@@ -273,8 +1310,7 @@ double CONSTVEL_MDL::getContinueLogLikelihood( MDL_STATE *s )
     int m = cs->m_numSkipped;
     double endProb = 1.0 - exp( -m / m_lambda_x);
     endProb += (endProb == 0.0) ? EPSILON : 0.0;
-    m_continueLogLikelihood = log(1.0-endProb);
-    return m_continueLogLikelihood;
+    return log(1.0-endProb);
 }
 
 
@@ -343,10 +1379,10 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
         CONSTPOS_REPORT *report )
 {
     CONSTVEL_STATE *nextState;          // new state
-    static MATRIX v( 2,1 );              // innovation
-    double distance;                   // mahalanobis distance
+    FIXED_MATRIX< 2, 1 > v;            // innovation
+    MHT_REAL distance;                 // mahalanobis distance
 
-    static MATRIX H(2,4);
+    FIXED_MATRIX< 2, 4 > H;
     H.set(1., 0., 0., 0.,
           0., 0., 1., 0.);
 
@@ -370,6 +1406,8 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
                                         y,
                                         0.,
                                         report->m_textureInfo,
+                                        report->m_windowMean[CORNER_WINDOWS::CENTER_WINDOW],
+                                        report->m_windowSigma[CORNER_WINDOWS::CENTER_WINDOW],
                                         m_startP,
                                         m_startLogLikelihood,
                                         0 );
@@ -378,7 +1416,7 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
     {
         /* continuing an existing CORNER_TRACK, skipping a measurement */
 
-        state->setup( m_processVariance, m_R );
+        state->setup();
 
 #ifdef DEBUG1
         printf("Skipping meas(report=0); continued state= %lf %lf %lf %lf\n",
@@ -392,6 +1430,8 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
                                         state->getY1(),
                                         state->getDY1(),
                                         state->m_prevTextureInfo,
+                                        state->m_textureMean,
+                                        state->m_textureSigma,
                                         state->getNextP(),
                                         0.,
                                         state->getNumSkipped() + 1 );
@@ -400,9 +1440,16 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
     {
         /* continuing an existing CORNER_TRACK, with a measurement */
 
-        state->setup( m_processVariance, m_R );
+        state->setup();
+
+        /* most pairs fail this, and it needs no matrix arithmetic */
+        if( state->isOutsideGateBox( report->getX(), report->getY() ) )
+        {
+            return 0;
+        }
+
         v = report->getZ() - H * state->getPrediction();
-        distance = (v.trans() * state->getSinv() * v)();
+        distance = state->getSChol().mahalanobis( v );
 #ifdef DEBUG1
         printf("\nPredicted State:\n");
         (state->getPrediction()).print(2);
@@ -410,8 +1457,8 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
         (report->getZ()).print(3);
         printf("\nInnovation:\n ");
         v.print(4);
-        printf("\nSinv:\n");
-        (state->getSinv()).print(5);
+        printf("\nS_chol:\n");
+        (state->getSChol()).print(5);
         printf("\nMahalinobus dist(innovTrans * s_inv * innov)=%lf maxDist=%lf\n",
                distance,m_maxDistance);
 #endif
@@ -439,8 +1486,8 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
                 (report->getZ()).print(3);
                 printf("\nInnovation:\n ");
                 v.print(4);
-                printf("\nSinv:\n");
-                (state->getSinv()).print(5);
+                printf("\nS_chol:\n");
+                (state->getSChol()).print(5);
                 printf("\nMahalinobus dist(innovTrans * s_inv * innov)=%lf maxDist=%lf\n",
                        distance,m_maxDistance);
                 printf("intDist=%lf\n",intDistance);
@@ -459,7 +1506,7 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
             }
             else
             {
-                MATRIX new_m_x =  state->getPrediction() + state->getW() * v;
+                FIXED_MATRIX< 4, 1 > new_m_x =  state->getPrediction() + state->getW() * v;
 
 #ifdef DEBUG1
                 printf("   Updated State:\n");
@@ -477,6 +1524,8 @@ CONSTVEL_STATE* CONSTVEL_MDL::getNextState( CONSTVEL_STATE *state,
                                                 new_m_x(2),
                                                 new_m_x(3),
                                                 report->m_textureInfo,
+                                                report->m_windowMean[CORNER_WINDOWS::CENTER_WINDOW],
+                                                report->m_windowSigma[CORNER_WINDOWS::CENTER_WINDOW],
                                                 state->getNextP(),
                                                 state->getLogLikelihoodCoef() -
                                                 distance / 2,
@@ -534,9 +1583,18 @@ CONSTVEL_MDL::CONSTVEL_MDL( double positionMeasureVarianceX,
     m_processVariance( processVariance ),
     m_intensityVariance( intensityVariance ),
     m_intensityThreshold( intensityThreshold ),
+    m_maxSpeed( 0 ),
+    m_transition( 0 ),
+    m_nextTransition( 0 ),
+    m_steadyStateTolerance( 0 ),
+    m_steadyFilter( 0 ),
+    m_steadyStateSteps( 0 ),
+    m_numExactStates( 0 ),
+    m_numSteadyStates( 0 ),
+    m_maxSteadyStateDeviation( 0 ),
     m_stateVariance( stateVar ),
-    m_R( 2, 2 ),
-    m_startP( 4, 4 )
+    m_R(),
+    m_startP()
 {
 
     std::cout << "\nSTARTING A NEW CONSTVEL_MDL\n";
@@ -544,23 +1602,27 @@ CONSTVEL_MDL::CONSTVEL_MDL( double positionMeasureVarianceX,
     double pVx = positionMeasureVarianceX;
     double pVy = positionMeasureVarianceY;
     double gV = gradientMeasureVariance;
-    MATRIX Q (4, 4 );
+    int i;
 
 
     m_R.set(  pVx, 0.,
               0., pVy );
 
-    Q.set(  1./3, 1./2,   0.,   0.,
-            1./2,   1.,   0.,   0.,
-            0.,   0., 1./3, 1./2,
-            0.,   0., 1./2,   1.   );
-
-    Q = Q * m_processVariance;
-
-    m_startP.set(pVx , 0., 0., 0.,
-                 0., m_stateVariance, 0., 0.,
-                 0., 0., pVy, 0.,
-                 0., 0., 0., m_stateVariance );
+    /* until beginScan() says otherwise, scans are a unit of time
+       apart */
+    for( i = 0; i < NUM_TRANSITIONS; i++ )
+    {
+        m_transitions[ i ] = 0;
+    }
+    m_transitions[ 0 ] = new CONSTVEL_TRANSITION( 1., m_processVariance );
+    m_transition = m_transitions[ 0 ];
+    m_nextTransition = 1;
+
+    m_startP = 0.;
+    m_startP( 0, 0 ) = pVx;
+    m_startP( 1, 1 ) = m_stateVariance;
+    m_startP( 2, 2 ) = pVy;
+    m_startP( 3, 3 ) = m_stateVariance;
 #ifdef DEBUG1
     std::cout << "\nstartP:\n";
     m_startP.print();
@@ -569,6 +1631,68 @@ CONSTVEL_MDL::CONSTVEL_MDL( double positionMeasureVarianceX,
     type = 2;
 }
 
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::~CONSTVEL_MDL() -- destructor for the CONSTVEL_MDL
+ *-------------------------------------------------------------------*/
+
+CONSTVEL_MDL::~CONSTVEL_MDL()
+{
+
+
+    int i;
+
+    for( i = 0; i < NUM_TRANSITIONS; i++ )
+    {
+        delete m_transitions[ i ];
+    }
+}
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::beginScan() -- get ready to predict states timeStep
+ |                              ahead
+ |
+ | The F and Q matrices of the last NUM_TRANSITIONS time steps are
+ | kept, so a sequence that keeps to a few frame rates only works
+ | them out once for each.  In steady-state mode, the converged
+ | filter is found again whenever the time step changes.
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_MDL::beginScan( double timeStep )
+{
+
+
+    MHT_REAL ds = timeStep;
+    int i;
+
+    if( ds == m_transition->m_ds )
+    {
+        return;
+    }
+
+    for( i = 0; i < NUM_TRANSITIONS; i++ )
+        if( m_transitions[ i ] != 0 && m_transitions[ i ]->m_ds == ds )
+        {
+            break;
+        }
+
+    if( i == NUM_TRANSITIONS )
+    {
+        i = m_nextTransition;
+        m_nextTransition = (m_nextTransition + 1) % NUM_TRANSITIONS;
+
+        delete m_transitions[ i ];
+        m_transitions[ i ] = new CONSTVEL_TRANSITION( ds,
+                                                      m_processVariance );
+    }
+
+    m_transition = m_transitions[ i ];
+
+    if( m_steadyStateTolerance > 0 )
+    {
+        findSteadyFilter();
+    }
+}
+
 
 /*--------------------------------------------------------*
  * getTrackColor( int trackId )
@@ -697,26 +1821,27 @@ double CONSTVEL_MDL::getCorr(CONSTVEL_STATE *state, CONSTPOS_REPORT *report)
            report->m_textureInfo[4]);
 #endif
 
-    int width = 5;
+#ifdef SUM_SQUAREDIFF
+    const int width = Texture_t::WIDTH;
+    const int r = TEMPLATE_RADIUS;
     int xm,ym;
     int index;
-#ifdef SUM_SQUAREDIFF
-    double minDist = HUGE;
-    for (int p = 1 ; p<=3 ; p++)
+    double minDist = HUGE_VAL;
+    for (int p = r ; p<width-r ; p++)
     {
         ym=p;
-        for (int q = 1; q<=3 ; q++)
+        for (int q = r; q<width-r ; q++)
         {
             xm=q;
             double dist = 0.0;
-            for (int j=-1; j<=1 ; j++)
+            for (int j=-r; j<=r ; j++)
             {
                 int y = ym + j ;
-                int y1 = 2+j;  // pattern window is centered around middle
-                for (int i=-1; i<=1; i++)
+                int y1 = TEXTURE_RADIUS+j;  // pattern window is centered around middle
+                for (int i=-r; i<=r; i++)
                 {
                     int x=xm + i ;
-                    int x1 = 2 + i;
+                    int x1 = TEXTURE_RADIUS + i;
                     index = width * y + x;
                     int index1 = width * y1 + x1;
                     dist += (double)(state->m_prevTextureInfo[index1] - report->m_textureInfo[index]) *
@@ -739,105 +1864,133 @@ double CONSTVEL_MDL::getCorr(CONSTVEL_STATE *state, CONSTPOS_REPORT *report)
 
 #ifdef CORR_COEFF
 
-    double stateMean, stateSigma;
-    double reportMean, reportSigma;
+    /*
+     *Slide the pattern window i.e the template-sized sub window of the
+     * texture patch of the previous state centered at the middle, over
+     * the report's search windows, whose statistics were found by
+     * CONSTPOS_REPORT::computeTextureStats()
+     */
+    double stateDev[ CORNER_WINDOWS::NUM_PIXELS ];
+    double maxCorr;
+
+    state->getTextureDev(stateDev);
+    int inRange = TextureCorr< TEMPLATE_RADIUS, TEXTURE_RADIUS >(
+                      stateDev, state->m_textureSigma,
+                      &report->m_windowDev[0][0],
+                      report->m_windowSigma, &maxCorr);
+    assert(inRange);// {
+    //   fprintf(stderr, "Error in corr calculation\n");
+    //   exit(1);
+    // }
 
-    /* Precompute the previous Mean and sigma */
-    xm=ym=2;
-    stateMean=stateSigma=0.0;
-    int j = -1;
-    for (j=-1; j<=1 ; j++)
+#ifdef DEBUG3
+    printf("MAXCorr=%lf  ",maxCorr);
+#endif
+    return maxCorr;
+#endif
+}
+
+/*-------------------------------------------------------------------*
+ | MAX_STEADY_STATE_STEPS -- limit on the number of filter steps taken
+ |                           to find the converged covariance
+ *-------------------------------------------------------------------*/
+
+static const int MAX_STEADY_STATE_STEPS = 1000;
+
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::setSteadyStateTolerance() -- turn steady-state mode
+ |                                            on (tolerance > 0) or
+ |                                            off (tolerance == 0)
+ |
+ | This should be called before any states are set up.
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_MDL::setSteadyStateTolerance( double tolerance )
+{
+
+
+    if( m_steadyFilter != 0 )
     {
-        int y = ym + j ;
-        for (int i=-1; i<=1; i++)
-        {
-            int x=xm + i ;
-            index = width * y + x;
-            stateMean += (double)(state->m_prevTextureInfo[index]);
-            stateSigma += (double)(state->m_prevTextureInfo[index]) *( state->m_prevTextureInfo[index]);
-        }
+        m_filterCache.release( m_steadyFilter );
+        m_steadyFilter = 0;
     }
-    stateMean /= 9;
-    stateSigma /= 9;
-    stateSigma = stateSigma -stateMean*stateMean;
-    stateSigma= sqrt(stateSigma);
 
+    m_steadyStateTolerance = tolerance > 0 ? tolerance : 0;
+    if( m_steadyStateTolerance == 0 )
+    {
+        return;
+    }
 
+    findSteadyFilter();
+}
 
-    /*
-     *Slide the pattern window i.e the 3x3 sub window of the 5x5 window of
-     * the previous state centered at the middle
-     */
-    double maxCorr = -HUGE;
-    for (int p = 1 ; p<=3 ; p++)
-    {
-        ym=p;
-        for (int q = 1; q<=3 ; q++)
-        {
-            xm=q;
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::findSteadyFilter() -- make the converged filter for
+ |                                     the current time step
+ |
+ | The converged covariance is found by running the covariance update
+ | from m_startP until it stops changing by more than a small fraction
+ | of the tolerance.  Since a skipped report doesn't change the
+ | covariance update in this model (the next state always gets the
+ | updated covariance), one converged filter covers every number of
+ | consecutive skips.
+ *-------------------------------------------------------------------*/
 
-            /* Find the mean & sigma of the search window */
-            reportMean=reportSigma=0.0;
-            for (j=-1; j<=1 ; j++)
-            {
-                int y = ym + j ;
-                for (int i=-1; i<=1; i++)
-                {
-                    int x=xm + i ;
-                    index = width * y + x;
-                    reportMean += (double)(report->m_textureInfo[index]);
-                    reportSigma += (double)(report->m_textureInfo[index])*( report->m_textureInfo[index]);
-                }
-            }
-            reportMean /= 9.;
-            reportSigma /= 9.;
-            reportSigma = reportSigma -reportMean*reportMean;
-            reportSigma = sqrt(reportSigma);
-
-            /* Compute the max correlation coeff of the 3x3 window */
-            double corr = 0.0;
-            for (int j=-1; j<=1 ; j++)
-            {
-                int y = ym + j ;
-                int y1 = 2 + j;
-                for (int i=-1; i<=1; i++)
-                {
-                    int x=xm + i ;
-                    int x1 = 2 + i;
-                    index = width * y + x;
-                    int index1 = width *y1 + x1;
-                    corr += (double)(state->m_prevTextureInfo[index1] - stateMean) *
-                            (double)(report->m_textureInfo[index] - reportMean);
-                }
-            }
+void CONSTVEL_MDL::findSteadyFilter()
+{
 
-            corr = corr != 0.0 || 
-                   reportSigma * stateSigma != 0.0 ? corr / (9.0 * reportSigma * stateSigma)
-                                                   : 1.0;
 
-            assert(corr >= -1.0 && corr <= 1.0);// {
-            //   fprintf(stderr, "Error in corr calculation\n");
-            //   exit(1);
-            // }
-            if (corr > maxCorr)
-            {
-                maxCorr = corr;
-            }
+    FIXED_SYMMETRIC< 4 > P( m_startP );
+    double change;
 
-#ifdef DEBUG3
-            printf("Corr(%d %d)=%lf  ",ym,xm,corr);
-#endif
+    if( m_steadyFilter != 0 )
+    {
+        m_filterCache.release( m_steadyFilter );
+        m_steadyFilter = 0;
+    }
 
+    for( m_steadyStateSteps = 0;
+         m_steadyStateSteps < MAX_STEADY_STATE_STEPS;
+         m_steadyStateSteps++ )
+    {
+        CONSTVEL_FILTER filter( P, 0, *m_transition, m_R, m_maxDistance );
 
+        change = relativeDifference( filter.m_nextP, P );
+        P = filter.m_nextP;
+        if( change <= m_steadyStateTolerance * 1e-3 )
+        {
+            break;
         }
     }
 
-#ifdef DEBUG3
-    printf("MAXCorr=%lf  ",maxCorr);
-#endif
-    return maxCorr;
-#endif
+    /* the model holds on to this one until it finds another */
+    m_steadyFilter = m_filterCache.get( P, *m_transition, m_R,
+                                        m_maxDistance );
 }
 
+/*-------------------------------------------------------------------*
+ | CONSTVEL_MDL::printSteadyStateStats() -- report how much use was
+ |                                          made of the converged
+ |                                          filter, and how far the
+ |                                          states using it were from
+ |                                          their exact filters
+ *-------------------------------------------------------------------*/
+
+void CONSTVEL_MDL::printSteadyStateStats()
+{
 
 
+    if( m_steadyFilter == 0 )
+    {
+        std::cout << "Steady-state mode is off" << std::endl;
+        return;
+    }
+
+    std::cout << "Steady-state tolerance " << m_steadyStateTolerance
+              << " (converged in " << m_steadyStateSteps << " steps):\n"
+              << "  " << m_numSteadyStates << " states used the"
+              << " converged filter, " << m_numExactStates
+              << " used exact filters\n"
+              << "  largest relative covariance difference "
+              << m_maxSteadyStateDeviation << std::endl;
+}
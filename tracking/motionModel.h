@@ -42,6 +42,20 @@
  *   CONSTPOS_REPORT (probably CORNER_TRACK_MHT::measure(), in       *
  *   trackCorners.c).                                                *
  *                                                                   *
+ *   Each CONSTPOS_REPORT also keeps the statistics of the template- *
+ *   sized windows of its texture patch that CONSTVEL_MDL::getCorr() *
+ *   needs: their means and standard deviations, and their pixels    *
+ *   with the mean subtracted.  The sizes come from TEXTURE_RADIUS   *
+ *   and TEMPLATE_RADIUS (see corner.h); by default there are nine   *
+ *   3x3 windows in a 5x5 patch.  The statistics are computed once,  *
+ *   by computeTextureStats(), when the reports of a scan are made.  *
+ *   A CONSTVEL_STATE carries the mean and standard deviation of the *
+ *   centre window of its texture, taken from the report it was      *
+ *   made from, so getCorr() only has to take one dot product per    *
+ *   window.  Those are done by TextureCorr() (see gate.H), and      *
+ *   CONSTVEL_MDL::gateReports() uses the batch form to screen all   *
+ *   the reports that pass the Mahalanobis test at once.             *
+ *                                                                   *
  *                          CONSTVEL_STATE                           *
  *                                                                   *
  *   The member variables of CONSTVEL_STATEs can be divided into two *
@@ -59,12 +73,75 @@
  *   the CONSTVEL_STATE's construction, since the CONSTVEL_STATE     *
  *   might be pruned away from the tree before it has a chance to    *
  *   have any reports validated to it.  Instead, they are computed   *
- *   by the member function setup().                                 *
+ *   at the start of the scan that the state is first grown in, by   *
+ *   CONSTVEL_MDL::prepareStates(), which is handed all the states   *
+ *   being grown at once (see below).  The member function setup()   *
+ *   does the same for a single state, if it's needed before then.   *
+ *   What follows describes the work done for each state.            *
+ *                                                                   *
+ *   The first thing that's done is to decide the length of the time *
+ *   step to use.  It's the time since the previous scan, which the  *
+ *   MHT passes on to CONSTVEL_MDL::beginScan() at the start of each *
+ *   scan.  The time step is stored in the member variable m_ds.     *
+ *                                                                   *
+ *   Then a gate box is computed: the axis-aligned box around the    *
+ *   predicted position that bounds the Mahalanobis validation gate, *
+ *   cut down to the distance the target could have moved at the     *
+ *   model's maximum speed (if one has been set).  Reports outside   *
+ *   the box are rejected with a few comparisons, before any matrix  *
+ *   arithmetic is done.                                             *
+ *                                                                   *
+ *                          CONSTVEL_FILTER                          *
+ *                                                                   *
+ *   Most of what a state needs -- the Cholesky factor of the        *
+ *   innovation covariance, the filter gain, the next covariance and *
+ *   the constant part of the likelihood -- depends only on the      *
+ *   state's covariance and time step, not on the state estimate.    *
+ *   Since every track starts with the same covariance, and it's     *
+ *   updated the same way whatever the reports are, many states have *
+ *   identical covariances.  So these values are kept in a           *
+ *   CONSTVEL_FILTER, and a CONSTVEL_FILTER_CACHE in the model makes *
+ *   sure that there's only one CONSTVEL_FILTER for each distinct    *
+ *   covariance and time step.  States share their CONSTVEL_FILTERs, *
+ *   which are reference counted and deleted when the last state     *
+ *   using them is cleaned up.  The cache compares covariances bit   *
+ *   for bit, so sharing doesn't change any results.                 *
+ *                                                                   *
+ *   prepareStates() works on blocks of states.  It first finds the  *
+ *   filters already in the cache, then makes all the missing ones   *
+ *   together (CONSTVEL_FILTER::computeBatch()), and then predicts   *
+ *   the states and works out their gate boxes.  The last two steps  *
+ *   keep their numbers in arrays, one per matrix entry, with an     *
+ *   element for each filter or state in the block, so each piece of *
+ *   arithmetic is a loop straight down an array that the compiler   *
+ *   can vectorize.  Every entry is computed with the same           *
+ *   operations, in the same order, as the FIXED_MATRIX expressions  *
+ *   they replace, so the results don't depend on how the states are *
+ *   batched.                                                        *
+ *                                                                   *
+ *   The state transition and process covariance matrices, F and Q,  *
+ *   depend only on the time step.  They're kept in a                *
+ *   CONSTVEL_TRANSITION, and the model keeps the ones for the last  *
+ *   few time steps it's seen, so they're only worked out again when *
+ *   the time step changes to a new value.                           *
  *                                                                   *
- *   The first thing that setup() does is to decide the length of    *
- *   the time step to use.  The time step is chosen such that it     *
- *   makes the predicted state estimate land in a neighboring pixel. *
- *   The time step is stored in the member variable m_ds.            *
+ *   While the time step stays the same, F, Q, H and R are fixed, so *
+ *   the covariance converges after a few steps.  In steady-state    *
+ *   mode (see CONSTVEL_MDL::setSteadyStateTolerance()) the model    *
+ *   works out the converged covariance for the current time step in *
+ *   advance (and again whenever the time step changes), and any     *
+ *   state whose covariance is within the tolerance of it uses the   *
+ *   converged filter instead of an exact one.  This is an           *
+ *   approximation: each such state records its relative distance    *
+ *   from the converged covariance, which the model summarizes in    *
+ *   printSteadyStateStats().                                        *
+ *                                                                   *
+ *   The numbers that states and filters keep are MHT_REAL's (see    *
+ *   precision.H), so when the program and the mht library are built *
+ *   with MHT_SINGLE_PRECISION they're floats, a state takes about   *
+ *   half the room, and all the filter arithmetic is done in single  *
+ *   precision.  The model's parameters, and the likelihoods handed  *
+ *   to the MHT, stay doubles.                                       *
  *                                                                   *
  *                           CONSTVEL_MDL                            *
  *                                                                   *
@@ -110,9 +187,19 @@
 #include "mdlmht.h"
 #include "param.h"
 #include "corner.h"
+#include "gate.h"
+#include "pool.h"
 #include <math.h>
 #include <cstdio>		// for  sprintf
 #include <list>			// for std::list<>
+#include <mutex>		// for std::mutex
+#include <atomic>		// for std::atomic<>
+
+/*
+ * CORNER_WINDOWS -- sizes of the windows that textures are compared
+ * in (see TEXTURE_WINDOWS in gate.H)
+ */
+typedef TEXTURE_WINDOWS< TEMPLATE_RADIUS, TEXTURE_RADIUS > CORNER_WINDOWS;
 
 static int g_numTracks;
 
@@ -121,6 +208,8 @@ class CORNER_TRACK_MDL;
 class CONSTPOS_STATE;
 class CONSTPOS_MDL;
 class CONSTVEL_STATE;
+class CONSTVEL_FILTER;
+class CONSTVEL_FILTER_CACHE;
 class CONSTVEL_MDL;
 class CONSTCURV_STATE;
 class CONSTCURV_MDL;
@@ -150,19 +239,31 @@ private:
     double m_falarmLogLikelihood;    // log of the likelihood that
                                      // this report is a false alarm
                                      // (not really part of a CORNER_TRACK)
-    MATRIX m_z;                      // (x, dx, y, dy)
+    FIXED_MATRIX< 2, 1 > m_z;        // (x, y)
 
 public:
     Texture_t m_textureInfo;
     int m_frameNo;
     size_t m_cornerID;
+
+    /* statistics of the template-sized windows of m_textureInfo, in
+       the order getCorr() slides over them (see computeTextureStats()) */
+    double m_windowMean[ CORNER_WINDOWS::NUM_WINDOWS ];
+    double m_windowSigma[ CORNER_WINDOWS::NUM_WINDOWS ];
+    double m_windowDev[ CORNER_WINDOWS::NUM_PIXELS ]
+                      [ CORNER_WINDOWS::NUM_WINDOWS ];
+                                     // [ k ][ w ] is pixel k of
+                                     //   window w minus the window's
+                                     //   mean, as TextureCorr()
+                                     //   wants them
+
     CONSTPOS_REPORT( const double &falarmLogLikelihood,
                      const double &x, const double &y,
                      const Texture_t &textureInfo,
                      const int &f, const size_t &cornerID):
         MDL_REPORT(),
         m_falarmLogLikelihood( falarmLogLikelihood ),
-        m_z( 2, 1 ),
+        m_z(),
         m_frameNo(f),
         m_textureInfo(textureInfo),
         m_cornerID(cornerID)
@@ -179,8 +280,13 @@ public:
 	m_textureInfo(src.m_textureInfo),
         m_cornerID(src.m_cornerID)
     {
+        memcpy( m_windowMean, src.m_windowMean, sizeof( m_windowMean ) );
+        memcpy( m_windowSigma, src.m_windowSigma, sizeof( m_windowSigma ) );
+        memcpy( m_windowDev, src.m_windowDev, sizeof( m_windowDev ) );
     }
 
+    void computeTextureStats();
+
     virtual void describe(int spaces)
     {
         m_z.print();
@@ -196,7 +302,7 @@ public:
         return m_falarmLogLikelihood;
     }
 
-    MATRIX &getZ()
+    FIXED_MATRIX< 2, 1 > &getZ()
     {
         return m_z;
     }
@@ -209,6 +315,12 @@ public:
     {
         return m_z( 1 );
     }
+    virtual int getPosition( double *x, double *y )
+    {
+        *x = m_z( 0 );
+        *y = m_z( 1 );
+        return 1;
+    }
     void printMeas()
     {
         printf("%lf %lf frame=%d\n",m_z(0),m_z(1),m_frameNo);
@@ -237,6 +349,140 @@ public:
 };
 
 
+/*-------------------------------------------------------------------*
+ *
+ * CONSTVEL_TRANSITION -- the state transition and process covariance
+ *                        matrices for one time step
+ *
+ *-------------------------------------------------------------------*/
+
+class CONSTVEL_TRANSITION
+{
+    friend class CONSTVEL_FILTER;
+    friend class CONSTVEL_FILTER_CACHE;
+    friend class CONSTVEL_MDL;
+
+private:
+
+    MHT_REAL m_ds;                   // time step
+    FIXED_MATRIX< 4, 4 > m_F;        // state transition matrix
+    FIXED_MATRIX< 4, 4 > m_Q;        // process covariance
+
+private:
+
+    CONSTVEL_TRANSITION( MHT_REAL ds, double processVariance );
+};
+
+/*-------------------------------------------------------------------*
+ *
+ * CONSTVEL_FILTER -- the report-independent parts of a Kalman filter
+ *                    step, for one covariance and time step
+ *
+ *-------------------------------------------------------------------*/
+
+class CONSTVEL_FILTER
+{
+    friend class CONSTVEL_FILTER_CACHE;
+    friend class CONSTVEL_STATE;
+    friend class CONSTVEL_MDL;
+
+private:
+
+    FIXED_SYMMETRIC< 4 > m_P;        // covariance and time step that
+    MHT_REAL m_ds;                   //   this filter was made for
+    unsigned long m_hash;            // hash of m_P and m_ds
+    int m_refCount;                  // number of states using this
+    CONSTVEL_FILTER *m_nextInBucket; // next filter in the same
+                                     //   CONSTVEL_FILTER_CACHE bucket
+
+    FIXED_MATRIX< 4, 4 > m_F;        // state transition matrix
+    MHT_REAL m_logLikelihoodCoef;    // part of likelihood calculation
+                                     //   that's independent of the
+                                     //   inovation
+    MHT_REAL m_gateHalfWidth;        // half the size of the gate box
+    MHT_REAL m_gateHalfHeight;
+    FIXED_CHOLESKY< 2 > m_sChol;     // Cholesky factor of the
+                                     //   innovation covariance
+    FIXED_MATRIX< 4, 2 > m_W;        // filter gain
+    FIXED_SYMMETRIC< 4 > m_nextP;    // updated state covariance
+                                     //   (covariance for next state)
+
+private:
+
+    CONSTVEL_FILTER( const FIXED_SYMMETRIC< 4 > &P, MHT_REAL ds,
+                     unsigned long hash );
+    CONSTVEL_FILTER( const FIXED_SYMMETRIC< 4 > &P, unsigned long hash,
+                     const CONSTVEL_TRANSITION &transition,
+                     const FIXED_MATRIX< 2, 2 > &R, double maxDistance );
+
+    static void computeBatch( CONSTVEL_FILTER **filters, int numFilters,
+                              const CONSTVEL_TRANSITION &transition,
+                              const FIXED_MATRIX< 2, 2 > &R,
+                              double maxDistance );
+
+    int matches( const FIXED_SYMMETRIC< 4 > &P, MHT_REAL ds,
+                 unsigned long hash )
+    {
+        return hash == m_hash && ds == m_ds &&
+               memcmp( P.getData(), m_P.getData(),
+                       FIXED_SYMMETRIC< 4 >::SIZE * sizeof( MHT_REAL ) ) == 0;
+    }
+};
+
+/*-------------------------------------------------------------------*
+ *
+ * CONSTVEL_FILTER_CACHE -- the CONSTVEL_FILTERs in use by the states
+ *                          of one CONSTVEL_MDL
+ *
+ * get() returns the CONSTVEL_FILTER for a covariance and time step,
+ * making it if there isn't one already, and release() is called when
+ * a state is done with it.  A batch of states can instead lookup()
+ * their filters, make the missing ones together, and add() them.
+ * All of these may be called from several threads at once.
+ *
+ *-------------------------------------------------------------------*/
+
+class CONSTVEL_FILTER_CACHE
+{
+private:
+
+    VECTOR_OF< CONSTVEL_FILTER * > m_buckets;
+    int m_numBuckets;
+    int m_numFilters;
+    std::mutex m_mutex;
+
+public:
+
+    CONSTVEL_FILTER_CACHE():
+        m_buckets(),
+        m_numBuckets( 0 ),
+        m_numFilters( 0 ),
+        m_mutex()
+    {
+    }
+
+    ~CONSTVEL_FILTER_CACHE();
+
+    static unsigned long hashKey( const FIXED_SYMMETRIC< 4 > &P,
+                                  MHT_REAL ds );
+
+    CONSTVEL_FILTER *get( const FIXED_SYMMETRIC< 4 > &P,
+                          const CONSTVEL_TRANSITION &transition,
+                          const FIXED_MATRIX< 2, 2 > &R,
+                          double maxDistance );
+    CONSTVEL_FILTER *lookup( const FIXED_SYMMETRIC< 4 > &P, MHT_REAL ds,
+                             unsigned long hash );
+    CONSTVEL_FILTER *add( CONSTVEL_FILTER *newFilter, int numRefs );
+    void hold( CONSTVEL_FILTER *filter );
+    int release( CONSTVEL_FILTER *filter );
+
+private:
+
+    CONSTVEL_FILTER *find( const FIXED_SYMMETRIC< 4 > &P, MHT_REAL ds,
+                           unsigned long hash );
+    void rehash( int numBuckets );
+};
+
 /*-------------------------------------------------------------------*
  *
  * CONSTVEL_MDL -- model for cornerTracks
@@ -246,33 +492,57 @@ public:
  * CONSTVEL_MDL describes the user's model of a CORNER_TRACK
  * Here the model is implemented as a simple linear Kalman filter
  *
+ * It's final so that CORNER_TRACK_MHT, a MDL_MHT_T< CONSTVEL_MDL >,
+ * can call its member functions directly
+ *
  *-------------------------------------------------------------------*/
 
 
-class CONSTVEL_MDL: public CORNER_TRACK_MDL
+class CONSTVEL_MDL final: public CORNER_TRACK_MDL
 {
+    friend class CONSTVEL_STATE;
+
 private:
     double m_lambda_x;
     double m_startLogLikelihood;     // likelihood of a CORNER_TRACK starting
-    double m_endLogLikelihood;       // likelihood of a CORNER_TRACK ending
-    double m_continueLogLikelihood;  // likelihood of a CORNER_TRACK not
-                                     //   ending
     double m_skipLogLikelihood;      // likelihood of not detecting a
                                      //   CORNER_TRACK that hasn't ended
     double m_detectLogLikelihood;    // likelihood of detecting a
                                      //   CORNER_TRACK that hasn't ended
 
-    double m_maxDistance;            // maximum mahalanobis distance
+    MHT_REAL m_maxDistance;          // maximum mahalanobis distance
                                      //   allowed for validating a
                                      //   report to a CORNER_TRACK
 
     double m_processVariance;        // process noise
     double m_intensityVariance;
     double m_stateVariance;
-    MATRIX m_R;                      // measurement covariance
-    MATRIX m_startP;                 // covariance matrix to use at
+    FIXED_MATRIX< 2, 2 > m_R;        // measurement covariance
+    FIXED_SYMMETRIC< 4 > m_startP;   // covariance matrix to use at
                                      //   start of a CORNER_TRACK
     double m_intensityThreshold;
+    double m_maxSpeed;               // maximum distance a CORNER_TRACK
+                                     //   can move per unit time
+                                     //   (0 if unbounded)
+    enum { NUM_TRANSITIONS = 4 };
+    CONSTVEL_TRANSITION *m_transitions[ NUM_TRANSITIONS ];
+                                     // F and Q for the last few time
+                                     //   steps (see beginScan())
+    CONSTVEL_TRANSITION *m_transition;  // the current scan's
+    int m_nextTransition;            // next of m_transitions to be
+                                     //   replaced
+    CONSTVEL_FILTER_CACHE m_filterCache;
+
+    double m_steadyStateTolerance;   // largest relative difference
+                                     //   from the converged covariance
+                                     //   for which the converged filter
+                                     //   is used (0 for exact filters)
+    CONSTVEL_FILTER *m_steadyFilter; // converged filter, or 0
+    int m_steadyStateSteps;          // steps taken to converge
+    std::atomic< long > m_numExactStates;  // states set up with an
+    std::atomic< long > m_numSteadyStates; //   exact filter, and with
+                                           //   the converged one
+    std::atomic< double > m_maxSteadyStateDeviation;
 
 public:
 
@@ -287,6 +557,7 @@ public:
                   double stateVar,
                   double intThreshold,
                   double maxDistance);
+    virtual ~CONSTVEL_MDL();
 
     virtual int beginNewStates( MDL_STATE *mdlState,
                                 MDL_REPORT *mdlReport );
@@ -302,10 +573,34 @@ public:
     }
     virtual double getStateX(MDL_STATE *s);
     virtual double getStateY(MDL_STATE *s);
+    virtual int getGateBox( MDL_STATE *mdlState,
+                            double *xMin, double *yMin,
+                            double *xMax, double *yMax );
+    virtual int gateReports( MDL_STATE *mdlState, int numReports,
+                             MDL_REPORT **reports,
+                             const MHT_REAL *x, const MHT_REAL *y,
+                             int *passed, MHT_REAL *distance );
+    virtual void beginScan( double timeStep );
+    virtual void prepareStates( MDL_STATE **mdlStates, int numStates );
+    virtual size_t releaseState( MDL_STATE *mdlState );
+    virtual int isReentrant()
+    {
+        return 1;
+    }
+
+    void setMaxSpeed( double maxSpeed )
+    {
+        m_maxSpeed = maxSpeed;
+    }
+
+    void setSteadyStateTolerance( double tolerance );
+    void printSteadyStateStats();
 
     double getCorr(CONSTVEL_STATE *s, CONSTPOS_REPORT *r);
 private:
 
+    void findSteadyFilter();
+
     CONSTVEL_STATE* getNextState( CONSTVEL_STATE *state,
                                   CONSTPOS_REPORT *report );
 };
@@ -328,9 +623,9 @@ class CONSTVEL_STATE: public MDL_STATE
 
 private:
 
-    MATRIX m_x;                      // state estimate (x, dx, y, dy)
-    MATRIX m_P;                      // covariance matrix
-    double m_logLikelihood;          // likelihood that this state
+    FIXED_MATRIX< 4, 1 > m_x;        // state estimate (x, dx, y, dy)
+    FIXED_SYMMETRIC< 4 > m_P;        // covariance matrix
+    MHT_REAL m_logLikelihood;        // likelihood that this state
                                      //   is the true state of the
                                      //   CORNER_TRACK after the state
                                      //   that it was born from (in
@@ -340,19 +635,21 @@ private:
     int m_hasBeenSetup;              // 0 before the following variables
                                      //   have been filled in, 1 after
 
-    double m_ds;                     // "time" step until the next state
-                                     //   (chosen so that the next state
-                                     //   lands in a neighboring pixel)
-    double m_logLikelihoodCoef;      // part of likelihood calculation
-                                     //   that's independent of the
-                                     //   inovation
-    MATRIX *m_Sinv;                  // inverse of the innovation
-                                     //   covariance
-    MATRIX *m_W;                     // filter gain
-    MATRIX *m_nextP;                 // updated state covariance
-                                     //   (covariance for next state)
-    MATRIX *m_x1;                    // state prediction
+    MHT_REAL m_ds;                   // time step until the next state
+                                     //   (the time between scans)
+    MHT_REAL m_gateXMin, m_gateXMax; // box that contains every report
+    MHT_REAL m_gateYMin, m_gateYMax; //   that could be validated to
+                                     //   this state
+    CONSTVEL_FILTER *m_filter;       // shared, covariance-dependent
+                                     //   parts of the filter step
+    MHT_REAL m_steadyStateDeviation; // relative difference between
+                                     //   m_P and the covariance that
+                                     //   m_filter was made for
+    FIXED_MATRIX< 4, 1 > m_x1;       // state prediction
     Texture_t m_prevTextureInfo;
+    double m_textureMean;            // mean and standard deviation of
+    double m_textureSigma;           //   the centre window of
+                                     //   m_prevTextureInfo
 
 private:
 
@@ -362,21 +659,24 @@ private:
                     const double &y,
                     const double &dy,
                     const Texture_t &info,
-                    MATRIX &P,
+                    double textureMean,
+                    double textureSigma,
+                    const FIXED_SYMMETRIC< 4 > &P,
                     const double &logLikelihood,
                     const int &numSkipped):
         MDL_STATE( mdl ),
         m_logLikelihood( logLikelihood ),
         m_hasBeenSetup( 0 ),
         m_numSkipped(numSkipped),
-        m_x(4,1),
+        m_x(),
         m_P(P),
         m_ds( 0 ),
-        m_x1( 0 ),
-        m_nextP( 0 ),
-        m_Sinv( 0 ),
-        m_W( 0 ),
-        m_prevTextureInfo(info)
+        m_filter( 0 ),
+        m_steadyStateDeviation( 0 ),
+        m_x1(),
+        m_prevTextureInfo(info),
+        m_textureMean(textureMean),
+        m_textureSigma(textureSigma)
     {
         m_x(0)=x;
         m_x(1)=dx;
@@ -393,36 +693,49 @@ private:
         m_hasBeenSetup( 0 ),
         m_numSkipped(src.m_numSkipped),
         m_ds( 0 ),
-        m_x1( 0 ),
-        m_nextP( 0 ),
-        m_Sinv( 0 ),
-        m_W( 0 ),
-        m_prevTextureInfo(src.m_prevTextureInfo)
+        m_filter( 0 ),
+        m_steadyStateDeviation( 0 ),
+        m_x1(),
+        m_prevTextureInfo(src.m_prevTextureInfo),
+        m_textureMean(src.m_textureMean),
+        m_textureSigma(src.m_textureSigma)
     {
     }
 
 
 private:
 
-    void setup( double processVariance, const MATRIX &R );
+    void setup()
+    {
+        MDL_STATE *state = this;
 
-    void cleanup()
+        if( ! m_hasBeenSetup )
+        {
+            getMdl()->prepareStates( &state, 1 );
+        }
+    }
+    void getTextureDev( double *dev );
+
+    /* returns the number of bytes freed */
+    size_t cleanup()
     {
 
 
+        size_t numFreed = 0;
+
         if( m_hasBeenSetup )
         {
-            delete m_x1;
-            m_x1 = 0;
-            delete m_nextP;
-            m_nextP = 0;
-            delete m_Sinv;
-            m_Sinv = 0;
-            delete m_W;
-            m_W = 0;
+            if( ((CONSTVEL_MDL *)getMdl())->m_filterCache.release(
+                    m_filter ) )
+            {
+                numFreed = sizeof( CONSTVEL_FILTER );
+            }
+            m_filter = 0;
 
             m_hasBeenSetup = 0;
         }
+
+        return numFreed;
     }
 
 
@@ -430,30 +743,38 @@ private:
     {
         return m_numSkipped;
     }
+
+    /* NOTE: written so that a NaN bound rejects nothing */
+    int isOutsideGateBox( double x, double y )
+    {
+        checkSetup();
+        return x < m_gateXMin || x > m_gateXMax ||
+               y < m_gateYMin || y > m_gateYMax;
+    }
     double getLogLikelihoodCoef()
     {
         checkSetup();
-        return m_logLikelihoodCoef;
+        return m_filter->m_logLikelihoodCoef;
     }
-    MATRIX &getPrediction()
+    FIXED_MATRIX< 4, 1 > &getPrediction()
     {
         checkSetup();
-        return *m_x1;
+        return m_x1;
     }
-    MATRIX &getNextP()
+    FIXED_SYMMETRIC< 4 > &getNextP()
     {
         checkSetup();
-        return *m_nextP;
+        return m_filter->m_nextP;
     }
-    MATRIX &getSinv()
+    FIXED_CHOLESKY< 2 > &getSChol()
     {
         checkSetup();
-        return *m_Sinv;
+        return m_filter->m_sChol;
     }
-    MATRIX &getW()
+    FIXED_MATRIX< 4, 2 > &getW()
     {
         checkSetup();
-        return *m_W;
+        return m_filter->m_W;
     }
 
 #ifdef TSTBUG
@@ -475,11 +796,29 @@ public:
     {
         cleanup();    //SHOULD THIS BE PRIVATE?
     }
+
+    /* states come and go by the thousand every scan, so their memory
+       is recycled (see pool.H) */
+    static void *operator new( size_t size )
+    {
+        return POOL_OF< CONSTVEL_STATE >::alloc( size );
+    }
+    static void operator delete( void *block, size_t size )
+    {
+        POOL_OF< CONSTVEL_STATE >::free( block, size );
+    }
     virtual double getLogLikelihood()
     {
         return m_logLikelihood;
     }
 
+    /* 0 unless the state was set up with the converged filter in
+       steady-state mode */
+    double getSteadyStateDeviation()
+    {
+        return m_steadyStateDeviation;
+    }
+
     virtual void print()
     {
         std::cout << "ConstVel State: "<< m_x(0) << " ,"
@@ -514,22 +853,22 @@ public:
     double getX1()
     {
         checkSetup();
-        return (*m_x1)( 0 );
+        return m_x1( 0 );
     }
     double getDX1()
     {
         checkSetup();
-        return (*m_x1)( 1 );
+        return m_x1( 1 );
     }
     double getY1()
     {
         checkSetup();
-        return (*m_x1)( 2 );
+        return m_x1( 2 );
     }
     double getDY1()
     {
         checkSetup();
-        return (*m_x1)( 3 );
+        return m_x1( 3 );
     }
 
     double getDS()
@@ -660,15 +999,17 @@ protected:
  *
  * CORNER_TRACK_MHT -- MDL_MHT class for CORNER_TRACK
  *
+ * All its models are CONSTVEL_MDLs
+ *
  *-------------------------------------------------------------------*/
 
-class CORNER_TRACK_MHT: public MDL_MHT
+class CORNER_TRACK_MHT: public MDL_MHT_T< CONSTVEL_MDL >
 {
 public:
 
     CORNER_TRACK_MHT( double fprob,int maxDepth, double minGHypoRatio, int maxGHypos,
                       ptrDLIST_OF<MODEL> mdlist ):
-        MDL_MHT( maxDepth, minGHypoRatio, maxGHypos ),
+        MDL_MHT_T< CONSTVEL_MDL >( maxDepth, minGHypoRatio, maxGHypos ),
         m_falarmLogLikelihood( log(fprob) ),
         m_cornerTracks(),
         m_falarms()
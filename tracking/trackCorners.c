@@ -29,6 +29,7 @@ int g_time;
 void PrintSyntax()
 {
     std::cerr << "trackCorners -o OUTFILE [-p PARAM_FILE] [-d DIRNAME] -i INFILE\n"
+              << "             [-s MAXSPEED] [-t THREADS] [-k TOLERANCE]\n"
               << "             [--syntax | -x] [--help | -h]\n";
 }
 
@@ -49,6 +50,20 @@ void PrintHelp()
     std::cerr << "-d --dir      DIRNAME\n"
               << "DIRNAME to prepend to the corner files.  Default is .\n\n";
 
+    std::cerr << "-s  --maxspeed  MAXSPEED\n"
+              << "Maximum distance a corner can move per unit of time (see the frame\n"
+              << "times in INFILE).  Reports further than this from a track are never\n"
+              << "validated to it.  Default is no limit.\n\n";
+
+    std::cerr << "-t  --threads  THREADS\n"
+              << "Number of threads used to grow the track trees.  The results are the\n"
+              << "same for any number.  Default is 1.\n\n";
+
+    std::cerr << "-k  --steadygain  TOLERANCE\n"
+              << "Use the converged (steady-state) Kalman filter for any track whose\n"
+              << "covariance is within TOLERANCE (relative) of the converged one.  This\n"
+              << "is faster but approximate.  Default is 0, exact filters only.\n\n";
+
     std::cerr << "-x  --syntax\n"
               << "Print the syntax for running this program.\n\n";
 
@@ -75,6 +90,9 @@ int main(int argc, char **argv)
     std::string paramFileName = "./Parameters";
     std::string inputFileName = "";
     std::string dirName = ".";
+    double maxSpeed = 0.0;
+    int numThreads = 1;
+    double steadyStateTolerance = 0.0;
 
     int OptionIndex = 0;
     int OptionChar = 0;
@@ -87,12 +105,15 @@ int main(int argc, char **argv)
         {"param", 1, NULL, 'p'},
         {"input", 1, NULL, 'i'},
 	{"dir", 1, NULL, 'd'},
+        {"maxspeed", 1, NULL, 's'},
+        {"threads", 1, NULL, 't'},
+        {"steadygain", 1, NULL, 'k'},
         {"syntax", 0, NULL, 'x'},
         {"help", 0, NULL, 'h'},
         {0, 0, 0, 0}
     };
 
-    while ((OptionChar = getopt_long(argc, argv, "o:p:i:d:xh", TheLongOptions, &OptionIndex)) != -1)
+    while ((OptionChar = getopt_long(argc, argv, "o:p:i:d:s:t:k:xh", TheLongOptions, &OptionIndex)) != -1)
     {
         switch (OptionChar)
         {
@@ -108,6 +129,15 @@ int main(int argc, char **argv)
 	case 'd':
 	    dirName = optarg;
 	    break;
+        case 's':
+            maxSpeed = atof(optarg);
+            break;
+        case 't':
+            numThreads = atoi(optarg);
+            break;
+        case 'k':
+            steadyStateTolerance = atof(optarg);
+            break;
         case 'x':
             PrintSyntax();
             return(1);
@@ -203,6 +233,8 @@ int main(int argc, char **argv)
       param.stateVariance,
       param.intensityThreshold,
       param.maxDistance2);
+    cvmdl->setMaxSpeed(maxSpeed);
+    cvmdl->setSteadyStateTolerance(steadyStateTolerance);
     mdl.append( (*cvmdl) );
 
 
@@ -217,6 +249,7 @@ int main(int argc, char **argv)
                           param.minGHypoRatio,
                           param.maxGHypos,
                           mdl );
+    mht.setNumThreads(numThreads);
 
 
 
@@ -262,6 +295,13 @@ int main(int argc, char **argv)
 
     }
 //    mht.describe();
+    if (steadyStateTolerance > 0)
+    {
+        cvmdl->printSteadyStateStats();
+    }
+    std::cout << "Memory freed from grown states: "
+              << mht.getReclaimedBytes() << " bytes" << std::endl;
+
     std::cout << "\n CLEARING \n" << std::endl;
     mht.clear();
 //    mht.describe();
@@ -631,13 +671,23 @@ std::list<CORNERLIST> readCorners(const std::string &inputFileName, const std::s
     float timeDelta = 1.;
     optionStrm >> timeDelta;
 
-    // Now, find out how many features are in each frame.
+    // Now, find out how many features are in each frame.  Each count
+    // can be followed, on the same line, by the time since the previous
+    // frame, if it's different from the usual timeDelta.
     for (int frameIndex=0; frameIndex < totalFrames; frameIndex++)
     {
-        controlFile >> npoints;
+        std::string frameLine;
+        do
+        {
+            std::getline(controlFile, frameLine);
+        } while (controlFile && frameLine.find_first_not_of(" \t\r") == std::string::npos);
+
+        std::stringstream frameStrm(frameLine);
+        float frameDelta = timeDelta;
+        frameStrm >> npoints >> frameDelta;
         ncorners.push_back(npoints);
         std::cout << "ncorners[" << frameIndex << "]=" << ncorners[frameIndex] << std::endl;
-        inputData.push_back(CORNERLIST(npoints, timeDelta));
+        inputData.push_back(CORNERLIST(npoints, frameDelta));
     }
 
     controlFile.close();
@@ -653,8 +703,7 @@ std::list<CORNERLIST> readCorners(const std::string &inputFileName, const std::s
          aCornerList++)
     {
         float x,y;
-        float i1,i2,i3,i4,i5,i6,i7,i8,i9,i10,i11,i12,i13,i14,i15;
-        float i16,i17,i18,i19,i20,i21,i22,i23,i24,i25;
+        float pixels[Texture_t::NUM_PIXELS];
         size_t cornerID;
         std::stringstream stringRep;
         stringRep << basename << '.' << i++;
@@ -671,11 +720,38 @@ std::list<CORNERLIST> readCorners(const std::string &inputFileName, const std::s
         int j=0;
         while (std::getline(inDataFile, str) && j < ncorners[i-startFrame-1])
         {
-            sscanf(str.c_str(),"%f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %zd",
-                   &x,&y,&i1,&i2,&i3,&i4,&i5,&i6,&i7,&i8, &i9, &i10, &i11, &i12, &i13, &i14,
-                   &i15,&i16, &i17, &i18, &i19, &i20, &i21, &i22, &i23, &i24, &i25, &cornerID );
-
-            aCornerList->list.push_back(CORNER(x,y, Texture_t(i1,i2,i3,i4,i5,i6,i7,i8,i9,i10,i11,i12,i13,i14,i15,i16,i17,i18,i19,i20,i21,i22,i23,i24,i25),i-1,cornerID));
+            // each line is x, y, the Texture_t::NUM_PIXELS pixels of
+            // the texture patch a row at a time, and the corner's ID.
+            // A line with too few or too many values most likely comes
+            // from a patch size other than the one compiled in, so it
+            // is an error rather than a corner with garbage in it.
+            const char *line = str.c_str();
+            int numChars = 0;
+            bool lineIsGood = (sscanf(line,"%f %f%n", &x, &y, &numChars) == 2);
+            line += numChars;
+            for (int k = 0; lineIsGood && k < Texture_t::NUM_PIXELS; k++)
+            {
+                numChars = 0;
+                lineIsGood = (sscanf(line,"%f%n", &pixels[k], &numChars) == 1);
+                line += numChars;
+            }
+            if (lineIsGood)
+            {
+                numChars = 0;
+                lineIsGood = (sscanf(line,"%zu%n", &cornerID, &numChars) == 1);
+                line += numChars;
+                lineIsGood = lineIsGood && line[strspn(line, " \t\r")] == '\0';
+            }
+            if (!lineIsGood)
+            {
+                std::stringstream msg;
+                msg << fname << ", line " << j + 1
+                    << ": expected x, y, " << (int)Texture_t::NUM_PIXELS
+                    << " pixel values and a corner ID";
+                throw std::runtime_error(msg.str());
+            }
+
+            aCornerList->list.push_back(CORNER(x,y, Texture_t(pixels),i-1,cornerID));
             j++;
 //            cornerID++;
         }